@@ -0,0 +1,116 @@
+/**
+ * @brief Measures the callback dispatch of an Emitter.
+ *
+ * @details Emits samples on an emitter without a data reader, so only the
+ *          dispatch to the registered callbacks is measured: synchronous
+ *          callbacks, asynchronous callbacks on a WorkStealingExecutor with
+ *          and without instance ordering, and a bounded callback queue. Batch
+ *          and lifecycle callbacks are added too, since message dispatch
+ *          should not pay for them. Build the same file against two commits
+ *          to compare them.
+ *
+ * @remarks Does not join a domain.
+ *
+ * Usage: ddw_emit_benchmark [samples] [callbacks] [instances]
+ */
+
+#include "dds_callback.h"
+#include "bench_typesTypeSupportImpl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+
+/// Emit count samples and print the average time per sample, including the
+/// time for the asynchronous callbacks to finish.
+void measure(const char* name,
+             Emitter<DDWBench::Sample>& emitter,
+             size_t count,
+             size_t instances,
+             const std::atomic<uint64_t>& calls,
+             uint64_t expected)
+{
+    DDWBench::Sample sample;
+    sample.label("benchmark");
+    DDS::SampleInfo info;
+    info.valid_data = true;
+
+    const uint64_t before = calls;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        sample.id(static_cast<int32_t>(i % instances));
+        sample.sequence(static_cast<int64_t>(i));
+        info.instance_handle = static_cast<DDS::InstanceHandle_t>(i % instances + 1);
+        emitter.emitMessage(sample, info);
+    }
+
+    // BLOCK never drops, so every callback runs
+    while (calls - before < expected)
+    {
+        std::this_thread::yield();
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double nanoseconds = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    std::cout << name << ": "
+              << nanoseconds / static_cast<double>(count) << " ns/sample" << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+    const size_t callbacks = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 4;
+    const size_t instances = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 16;
+
+    if (count == 0 || callbacks == 0 || instances == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [samples] [callbacks] [instances]" << std::endl;
+        return 1;
+    }
+
+    auto executor = std::make_shared<WorkStealingExecutor>();
+    std::atomic<uint64_t> calls(0);
+    const uint64_t expected = static_cast<uint64_t>(count) * callbacks;
+
+    Emitter<DDWBench::Sample> emitter(DDS::DataReader_var(), executor);
+    for (size_t i = 0; i < callbacks; i++)
+    {
+        if (i % 2 == 0)
+        {
+            emitter.addCallback(std::function<void(const DDWBench::Sample&)>(
+                [&calls](const DDWBench::Sample&) { calls++; }));
+        }
+        else
+        {
+            emitter.addCallback(std::function<void(const DDWBench::Sample&, const DDS::SampleInfo&)>(
+                [&calls](const DDWBench::Sample&, const DDS::SampleInfo&) { calls++; }));
+        }
+    }
+
+    // Never called by emitMessage
+    emitter.addBatchCallback([](const SampleBatch<DDWBench::Sample>&) {});
+    emitter.addLifecycleCallback([](const DDWBench::Sample&) {}, nullptr);
+
+    measure("sync", emitter, count, instances, calls, expected);
+
+    emitter.setAsync(true);
+    measure("async", emitter, count, instances, calls, expected);
+
+    emitter.setInstanceOrdering(true);
+    measure("async, instance ordering", emitter, count, instances, calls, expected);
+
+    emitter.setQueueLimit(1024, OverflowPolicy::BLOCK);
+    measure("async, instance ordering, queue limit 1024 (BLOCK)", emitter, count, instances, calls, expected);
+
+    emitter.stop();
+    executor->shutdown();
+    return 0;
+}
@@ -0,0 +1,112 @@
+/**
+ * @brief Measures the write path of DDSSimpleManager.
+ *
+ * @details Writes keyed samples on one topic through DDSSimpleManager::Write
+ *          (the type to topic lookup), Write with a topic name,
+ *          DDSManager::writeSample and a pre-resolved TopicWriter, and prints
+ *          the average time of each. Build the same file against two commits
+ *          to compare them.
+ *
+ * @remarks Joins a real domain. Set DDS_CONFIG_FILE to an RTPS configuration
+ *          (or run next to an opendds.ini), since the default discovery needs
+ *          an InfoRepo.
+ *
+ * Usage: ddw_write_benchmark [samples] [instances] [domain]
+ */
+
+#include "dds_simple.h"
+#include "bench_typesTypeSupportImpl.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+namespace {
+
+/// Call write count times and print the average time per call.
+template <typename Write>
+void measure(const char* name, size_t count, Write write)
+{
+    size_t failed = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!write(i))
+        {
+            failed++;
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const double nanoseconds = static_cast<double>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    std::cout << name << ": "
+              << nanoseconds / static_cast<double>(count) << " ns/write";
+    if (failed > 0)
+    {
+        std::cout << " (" << failed << " failed)";
+    }
+    std::cout << std::endl;
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const size_t count = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000;
+    const size_t instances = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 16;
+    const int domain = argc > 3 ? std::atoi(argv[3]) : 42;
+
+    if (count == 0 || instances == 0)
+    {
+        std::cerr << "Usage: " << argv[0] << " [samples] [instances] [domain]" << std::endl;
+        return 1;
+    }
+
+    const std::string topicName = "DDWBenchSample";
+
+    DDSSimpleManager manager;
+    if (!manager.joinDomain(domain))
+    {
+        std::cerr << "Unable to join domain " << domain << std::endl;
+        return 1;
+    }
+
+    if (!manager.Publisher<DDWBench::Sample>(topicName, STD_QOS::QosType::BEST_EFFORT))
+    {
+        std::cerr << "Unable to create a publisher on '" << topicName << "'" << std::endl;
+        return 1;
+    }
+
+    DDWBench::Sample sample;
+    sample.label("benchmark");
+    auto next = [&sample, instances](size_t i) -> const DDWBench::Sample&
+    {
+        sample.id(static_cast<int32_t>(i % instances));
+        sample.sequence(static_cast<int64_t>(i));
+        sample.value(static_cast<double>(i) * 0.5);
+        return sample;
+    };
+
+    // Register every instance before measuring
+    for (size_t i = 0; i < instances; i++)
+    {
+        manager.Write(next(i));
+    }
+
+    measure("DDSSimpleManager::Write<T>(sample)", count,
+        [&](size_t i) { return manager.Write(next(i)); });
+
+    measure("DDSSimpleManager::Write<T>(sample, topic)", count,
+        [&](size_t i) { return manager.Write(next(i), topicName); });
+
+    measure("DDSManager::writeSample<T>", count,
+        [&](size_t i) { return manager.writeSample(next(i), topicName); });
+
+    TopicWriter<DDWBench::Sample> writer = manager.getTopicWriter<DDWBench::Sample>(topicName);
+    measure("TopicWriter<T>::write", count,
+        [&](size_t i) { return writer.write(next(i)); });
+
+    return 0;
+}
@@ -0,0 +1,337 @@
+#ifndef __DDS_ASYNC_WRITER_H__
+#define __DDS_ASYNC_WRITER_H__
+
+#include "dds_topic_writer.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief What to do with a new sample when a bounded queue is full.
+ */
+enum class OverflowPolicy
+{
+    /// Block the caller until there is room in the queue.
+    BLOCK,
+    /// Discard the oldest queued sample to make room.
+    DROP_OLDEST,
+    /// Discard the new sample.
+    DROP_NEWEST,
+    /// Keep only the latest queued sample for each instance key.
+    CONFLATE
+};
+
+/**
+ * @brief Counters for an asynchronous publish queue.
+ */
+struct AsyncWriterStatistics
+{
+    /// Samples accepted into the queue.
+    uint64_t enqueued = 0;
+    /// Samples discarded by the overflow policy or replaced by conflation.
+    uint64_t dropped = 0;
+    /// Samples taken off the queue and written by the data writer.
+    uint64_t drained = 0;
+    /// Samples taken off the queue which the data writer failed to write,
+    /// such as reliable writes which timed out.
+    uint64_t failed = 0;
+};
+
+
+/**
+ * @brief Bounded lock-free queue for multiple producers.
+ *
+ * @details Based on Dmitry Vyukov's bounded MPMC queue. Every cell carries a
+ *          sequence number, so producers and consumers claim cells with a
+ *          single compare-and-swap. The capacity is rounded up to a power of
+ *          two.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+
+    explicit BoundedQueue(size_t capacity) :
+        m_enqueuePos(0), m_dequeuePos(0)
+    {
+        size_t size = 2;
+        while (size < capacity)
+        {
+            size <<= 1;
+        }
+
+        m_mask = size - 1;
+        m_cells.reset(new Cell[size]);
+        for (size_t i = 0; i < size; i++)
+        {
+            m_cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+    /**
+     * @brief Copy a value into the queue.
+     * @return True if the value was queued; false if the queue is full.
+     */
+    bool push(const T& value)
+    {
+        size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;)
+        {
+            cell = &m_cells[pos & m_mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->value = value;
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Move the oldest value out of the queue.
+     * @return True if a value was removed; false if the queue is empty.
+     */
+    bool pop(T& value)
+    {
+        size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        Cell* cell = nullptr;
+        for (;;)
+        {
+            cell = &m_cells[pos & m_mask];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0)
+            {
+                if (m_dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        value = std::move(cell->value);
+        cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// True if the next pop would find no value.
+    bool empty() const
+    {
+        const size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+        const size_t seq = m_cells[pos & m_mask].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1) < 0;
+    }
+
+    /// True if the next push would find no free cell.
+    bool full() const
+    {
+        const size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+        const size_t seq = m_cells[pos & m_mask].sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos) < 0;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> m_cells;
+    size_t m_mask;
+    std::atomic<size_t> m_enqueuePos;
+    std::atomic<size_t> m_dequeuePos;
+};
+
+
+/**
+ * @brief Type independent part of an asynchronous publish queue.
+ * @details Stored by the topic group so it can stop the sender thread
+ *          before the data writer is deleted.
+ */
+class AsyncWriterBase
+{
+public:
+
+    AsyncWriterBase() : m_enqueued(0), m_dropped(0), m_drained(0), m_failed(0)
+    {}
+
+    virtual ~AsyncWriterBase() = default;
+
+    /// Write the samples still queued and stop the sender thread.
+    virtual void stop() = 0;
+
+    /**
+     * @brief Write the queued samples on the calling thread right away.
+     * @remarks Ignores the flush interval.
+     * @return True if the queue is running; false after stop.
+     */
+    virtual bool flush() = 0;
+
+    AsyncWriterStatistics getStatistics() const
+    {
+        AsyncWriterStatistics stats;
+        stats.enqueued = m_enqueued.load();
+        stats.dropped = m_dropped.load();
+        stats.drained = m_drained.load();
+        stats.failed = m_failed.load();
+        return stats;
+    }
+
+protected:
+
+    std::atomic<uint64_t> m_enqueued;
+    std::atomic<uint64_t> m_dropped;
+    std::atomic<uint64_t> m_drained;
+    std::atomic<uint64_t> m_failed;
+};
+
+
+/**
+ * @brief Queues samples for a topic and writes them from a sender thread.
+ *
+ * @details Reliable data writers can block in write() for up to
+ *          max_blocking_time when their history is full. Queuing the sample
+ *          here returns immediately (except with OverflowPolicy::BLOCK on a
+ *          full queue) and a dedicated thread drains the queue into the data
+ *          writer. The BLOCK, DROP_OLDEST and DROP_NEWEST policies use a
+ *          lock-free queue. CONFLATE keeps the latest sample for each instance
+ *          key in a small mutex protected table instead.
+ *
+ *          A flush interval limits how often the sender thread drains the
+ *          queue. With CONFLATE, this writes at most one sample per instance
+ *          per interval however fast the samples are queued.
+ */
+template <typename TopicType>
+class AsyncWriter : public AsyncWriterBase
+{
+public:
+
+    /**
+     * @brief Start the sender thread for a topic.
+     * @param[in] writer Handle the queued samples are written to.
+     * @param[in] capacity Maximum number of queued samples (or instance
+     *            keys for OverflowPolicy::CONFLATE).
+     * @param[in] policy What to do when the queue is full.
+     * @param[in] flushInterval Minimum time between drains of the queue by
+     *            the sender thread. Zero drains as soon as samples arrive.
+     */
+    AsyncWriter(const TopicWriter<TopicType>& writer,
+                size_t capacity,
+                OverflowPolicy policy,
+                std::chrono::nanoseconds flushInterval = std::chrono::nanoseconds::zero());
+
+    ~AsyncWriter();
+
+    /**
+     * @brief Queue a sample to be written by the sender thread.
+     * @remarks A sample queued while stop runs is written by the calling
+     *          thread, so no sample accepted by the queue is left in it.
+     * @param[in] sample The sample to queue.
+     * @return True if the sample was queued; false if it was dropped.
+     */
+    bool write(const TopicType& sample);
+
+    void stop();
+
+    bool flush();
+
+private:
+
+    /// Sender thread loop.
+    void run();
+
+    /// Write everything currently queued.
+    void drain();
+
+    bool hasPending() const;
+
+    /// Wake the sender thread if it is waiting for samples.
+    void notifySender();
+
+    /// Wake producers waiting for room in the queue.
+    void notifyProducers();
+
+    bool conflate(const TopicType& sample);
+
+    TopicWriter<TopicType> m_writer;
+
+    const OverflowPolicy m_policy;
+
+    const size_t m_capacity;
+
+    const std::chrono::nanoseconds m_flushInterval;
+
+    BoundedQueue<TopicType> m_queue;
+
+    /// Latest pending sample per serialized instance key (CONFLATE only).
+    std::mutex m_conflateMutex;
+    std::unordered_map<uint64_t, size_t> m_pendingIndex;
+    std::vector<std::pair<std::string, TopicType>> m_pending;
+    std::atomic<size_t> m_pendingCount;
+
+    /// Keeps the sender thread and flush from draining at the same time.
+    std::mutex m_drainMutex;
+    std::vector<std::pair<std::string, TopicType>> m_draining;
+
+    std::atomic<bool> m_running;
+
+    std::atomic<bool> m_senderWaiting;
+    std::mutex m_senderMutex;
+    std::condition_variable m_senderCondition;
+
+    std::atomic<int> m_producersWaiting;
+    std::mutex m_producerMutex;
+    std::condition_variable m_producerCondition;
+
+    /// The sender thread
+    std::thread m_thread;
+};
+
+#endif
+
+/**
+ * @}
+ */
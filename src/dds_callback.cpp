@@ -1,26 +1,936 @@
 #include "dds_callback.h"
 
-EmitterBase::~EmitterBase() = default;
+#include <algorithm>
+#include <deque>
+#include <unordered_map>
+
+EmitterBase::EmitterBase(std::shared_ptr<CallbackExecutor> executor) :
+    m_running(false),
+    m_instanceOrdering(false),
+    m_strands(std::make_shared<InstanceStrands>(executor)),
+    m_eventPool(std::make_shared<CallbackEventPool>()),
+    m_stopping(false),
+    m_executor(executor)
+{}
+
+EmitterBase::~EmitterBase()
+{}
+
+/// A queued callback: a shared sample call, or fn when invoke is not set.
+struct PendingCallback {
+  std::shared_ptr<GenericCallback> callback;
+  std::shared_ptr<const void> sample;
+  EmitterBase::SharedInvoker invoke = nullptr;
+  std::function<void(void)> fn;
+
+  void operator()() const
+  {
+    if (invoke) {
+      invoke(*callback, sample.get());
+    }
+    else {
+      fn();
+    }
+  }
+};
 
 namespace {
 
-class std_fun_event : public OpenDDS::DCPS::EventBase {
+/// Runs one callback, then returns itself to the pool of its emitter.
+class callback_event : public OpenDDS::DCPS::EventBase {
+public:
+  void handle_event();
+
+  PendingCallback call;
+
+  /// Set while dispatched, so the pool outlives the event's emitter.
+  std::shared_ptr<CallbackEventPool> pool;
+};
+
+/**
+ * @brief Drains a strand or queue, then returns to its owner for reuse.
+ * @details Owner::drain either dispatches the event again or keeps it for
+ *          the next drain, so draining never allocates an event.
+ */
+template <typename Owner>
+class drain_event : public OpenDDS::DCPS::EventBase {
+public:
+  void handle_event()
+  {
+    // Released before the event can be reused
+    std::shared_ptr<Owner> self = std::move(owner);
+    self->drain(OpenDDS::DCPS::rchandle_from(this));
+  }
+
+  /// Set while dispatched, so queued callbacks outlive the emitter.
+  std::shared_ptr<Owner> owner;
+
+  /// The strand to drain.
+  DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+};
+
+}
+
+/**
+ * @brief Idle callback events of one emitter.
+ * @details The unordered asynchronous path takes an event from here instead
+ *          of allocating one per callback. Only the emitter thread and the
+ *          executor threads running its callbacks share the lock.
+ */
+class CallbackEventPool {
 public:
-  std_fun_event(std::function<void(void)> fn) : m_fn(fn) {}
 
-  void handle_event() { m_fn(); }
+  OpenDDS::DCPS::RcHandle<callback_event> acquire()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (!m_idle.empty()) {
+        OpenDDS::DCPS::RcHandle<callback_event> event = std::move(m_idle.back());
+        m_idle.pop_back();
+        return event;
+      }
+    }
+    return OpenDDS::DCPS::make_rch<callback_event>();
+  }
+
+  void release(OpenDDS::DCPS::RcHandle<callback_event> event)
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_idle.size() < MaxIdle) {
+      m_idle.push_back(std::move(event));
+    }
+  }
+
+  /// Run a callback on an executor thread with an event from the pool.
+  static void dispatch(CallbackExecutor& executor,
+                       const std::shared_ptr<CallbackEventPool>& pool,
+                       PendingCallback call)
+  {
+    OpenDDS::DCPS::RcHandle<callback_event> event = pool->acquire();
+    event->call = std::move(call);
+    event->pool = pool;
+    if (!executor.dispatch(event)) {
+      event->call = PendingCallback();
+      event->pool.reset();
+    }
+  }
 
 private:
-  std::function<void(void)> m_fn;
+  /// Enough for a burst; more are freed after running.
+  static constexpr size_t MaxIdle = 256;
+
+  std::mutex m_mutex;
+  std::vector<OpenDDS::DCPS::RcHandle<callback_event>> m_idle;
 };
 
+namespace {
+
+void callback_event::handle_event()
+{
+  call();
+
+  // Drop the sample before the event waits in the pool
+  call = PendingCallback();
+  std::shared_ptr<CallbackEventPool> owner = std::move(pool);
+  owner->release(OpenDDS::DCPS::rchandle_from(this));
+}
+
 }
 
-void EmitterBase::AddToThreadPool(std::function<void(void)> fn)
+/**
+ * @brief Runs the queued callbacks of each instance one at a time.
+ *
+ * @details A strand exists while it has callbacks queued. The first callback
+ *          queued on an idle strand dispatches a drain event, which runs the
+ *          strand's callbacks in order and removes the strand once it is
+ *          empty. Strands of different instances drain on different
+ *          executor threads. Drain events hold the strands, so callbacks
+ *          still queued when the emitter goes away run as they did before.
+ *          A strand has one drain event at a time, and finished drain events
+ *          are kept for the next strand.
+ */
+class InstanceStrands : public std::enable_shared_from_this<InstanceStrands> {
+public:
+
+  typedef drain_event<InstanceStrands> DrainEvent;
+
+  explicit InstanceStrands(std::shared_ptr<CallbackExecutor> executor) : m_executor(executor) {}
+
+  void post(DDS::InstanceHandle_t handle, PendingCallback call)
+  {
+    OpenDDS::DCPS::RcHandle<DrainEvent> event;
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      auto result = m_strands.emplace(handle, std::deque<PendingCallback>());
+      result.first->second.push_back(std::move(call));
+      if (!result.second) {
+        return;
+      }
+
+      if (!m_idleEvents.empty()) {
+        event = std::move(m_idleEvents.back());
+        m_idleEvents.pop_back();
+      }
+    }
+
+    if (!event) {
+      event = OpenDDS::DCPS::make_rch<DrainEvent>();
+    }
+    event->handle = handle;
+    schedule(event);
+  }
+
+  /// Run the callbacks of the strand of a drain event.
+  void drain(OpenDDS::DCPS::RcHandle<DrainEvent> event)
+  {
+    const DDS::InstanceHandle_t handle = event->handle;
+    for (size_t i = 0; i < MaxBatch; i++) {
+      PendingCallback call;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto iter = m_strands.find(handle);
+        if (iter != m_strands.end() && iter->second.empty()) {
+          m_strands.erase(iter);
+          iter = m_strands.end();
+        }
+
+        if (iter == m_strands.end()) {
+          // Another strand may take the event as soon as the lock is released
+          recycle(std::move(event));
+          return;
+        }
+
+        call = std::move(iter->second.front());
+        iter->second.pop_front();
+      }
+
+      call();
+    }
+
+    // Let other strands run before continuing with this one
+    schedule(event);
+  }
+
+private:
+
+  /// Callbacks run by one drain event before it yields to other strands.
+  static constexpr size_t MaxBatch = 64;
+
+  /// Finished drain events kept for new strands.
+  static constexpr size_t MaxIdle = 64;
+
+  void schedule(OpenDDS::DCPS::RcHandle<DrainEvent> event)
+  {
+    auto executor = m_executor.lock();
+    if (executor) {
+      event->owner = shared_from_this();
+      if (executor->dispatch(event)) {
+        return;
+      }
+      event->owner.reset();
+    }
+
+    // Nothing will drain the strand, so drop it rather than block it forever
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_strands.erase(event->handle);
+    recycle(std::move(event));
+  }
+
+  /// Keep a drain event which is no longer dispatched. Call with m_mutex held.
+  void recycle(OpenDDS::DCPS::RcHandle<DrainEvent> event)
+  {
+    if (m_idleEvents.size() < MaxIdle) {
+      m_idleEvents.push_back(std::move(event));
+    }
+  }
+
+  std::weak_ptr<CallbackExecutor> m_executor;
+
+  std::mutex m_mutex;
+
+  /// The queued callbacks of each instance with a drain event pending.
+  std::unordered_map<DDS::InstanceHandle_t, std::deque<PendingCallback>> m_strands;
+
+  std::vector<OpenDDS::DCPS::RcHandle<DrainEvent>> m_idleEvents;
+};
+
+namespace {
+
+/// The callback queue whose callback runs on the current thread.
+thread_local const CallbackQueue* t_draining = nullptr;
+
+}
+
+/**
+ * @brief A bounded queue of asynchronous callbacks.
+ *
+ * @details Callbacks wait here instead of in the executor, so the overflow
+ *          policy can drop or replace them. Up to one drain event per
+ *          executor thread runs the runnable callbacks oldest first. With
+ *          instance ordering, only the oldest callback of an instance is
+ *          runnable, and only while no other callback of its instance runs;
+ *          the drain running that one makes the next one runnable.
+ *          The queue owns its drain events and reuses them.
+ */
+class CallbackQueue : public std::enable_shared_from_this<CallbackQueue> {
+public:
+
+  typedef drain_event<CallbackQueue> DrainEvent;
+
+  CallbackQueue(size_t capacity, OverflowPolicy policy, std::shared_ptr<CallbackExecutor> executor) :
+    m_capacity(capacity > 0 ? capacity : 1),
+    m_policy(policy),
+    m_executor(executor),
+    m_maxDrains(executor ? std::max<size_t>(executor->getStatistics().threads, 1) : 1)
+  {}
+
+  /**
+   * @brief Queue a callback, applying the overflow policy when full.
+   * @param[in] stopping Set while the emitter stops; BLOCK drops instead.
+   * @return True if the callback was queued or conflated; false if dropped.
+   */
+  bool push(DDS::InstanceHandle_t handle, bool ordered, PendingCallback call, const std::atomic<bool>& stopping)
+  {
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    const bool conflate = m_policy == OverflowPolicy::CONFLATE && call.callback && handle != DDS::HANDLE_NIL;
+    const ConflationKey key{handle, call.callback.get()};
+    if (conflate) {
+      auto iter = m_conflation.find(key);
+      if (iter != m_conflation.end()) {
+        // Replace the queued sample of this instance
+        m_nodes[iter->second].call = std::move(call);
+        m_stats.dropped++;
+        return true;
+      }
+    }
+
+    while (m_size >= m_capacity) {
+      if (m_policy == OverflowPolicy::DROP_OLDEST) {
+        drop(m_oldest);
+        m_stats.dropped++;
+        continue;
+      }
+
+      // A callback of this queue which reads its own emitter would wait for
+      // itself, since only the drains make room
+      if (m_policy != OverflowPolicy::BLOCK || stopping || t_draining == this) {
+        m_stats.dropped++;
+        return false;
+      }
+
+      m_notFull.wait(lock, [this, &stopping]() { return m_size < m_capacity || stopping; });
+    }
+
+    const size_t index = allocate();
+    Node& node = m_nodes[index];
+    node.handle = handle;
+    node.ordered = ordered && handle != DDS::HANDLE_NIL;
+    node.call = std::move(call);
+    node.conflated = conflate;
+    if (conflate) {
+      m_conflation.emplace(key, index);
+    }
+
+    node.older = m_newest;
+    if (m_newest != Nil) {
+      m_nodes[m_newest].newer = index;
+    }
+    else {
+      m_oldest = index;
+    }
+    m_newest = index;
+    m_size++;
+
+    m_stats.enqueued++;
+    m_stats.highWaterMark = std::max(m_stats.highWaterMark, m_size);
+
+    // Only a runnable callback needs a drain; the others run after the
+    // callback of their instance which is queued or running
+    bool runnable = true;
+    if (node.ordered) {
+      Instance& instance = m_instances[handle];
+      runnable = instance.head == Nil && !instance.busy;
+      if (instance.tail != Nil) {
+        m_nodes[instance.tail].nextInstance = index;
+      }
+      else {
+        instance.head = index;
+      }
+      instance.tail = index;
+    }
+
+    if (!runnable) {
+      return true;
+    }
+    makeReady(index);
+
+    if (m_drains >= m_maxDrains) {
+      return true;
+    }
+
+    m_drains++;
+    OpenDDS::DCPS::RcHandle<DrainEvent> event;
+    if (!m_idleEvents.empty()) {
+      event = std::move(m_idleEvents.back());
+      m_idleEvents.pop_back();
+    }
+    lock.unlock();
+
+    if (!event) {
+      event = OpenDDS::DCPS::make_rch<DrainEvent>();
+    }
+    schedule(event);
+    return true;
+  }
+
+  /// Wake an emitter blocked in push.
+  void wake()
+  {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+    }
+    m_notFull.notify_all();
+  }
+
+  CallbackQueueStatistics getStatistics() const
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    CallbackQueueStatistics stats = m_stats;
+    stats.depth = m_size;
+    return stats;
+  }
+
+  /// Run queued callbacks until none is runnable.
+  void drain(OpenDDS::DCPS::RcHandle<DrainEvent> event)
+  {
+    for (size_t i = 0; i < MaxBatch; i++) {
+      Entry entry;
+      {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!popReady(entry)) {
+          // Another drain may take the event as soon as the lock is released
+          m_drains--;
+          m_idleEvents.push_back(std::move(event));
+          return;
+        }
+      }
+      m_notFull.notify_all();
+
+      const CallbackQueue* draining = t_draining;
+      t_draining = this;
+      entry.call();
+      t_draining = draining;
+
+      std::lock_guard<std::mutex> lock(m_mutex);
+      if (entry.ordered) {
+        finish(entry.handle);
+      }
+      m_stats.executed++;
+    }
+
+    // Let other events run before continuing
+    schedule(event);
+  }
+
+private:
+
+  /// Callbacks run by one drain event before it yields to other events.
+  static constexpr size_t MaxBatch = 64;
+
+  /// No node.
+  static constexpr size_t Nil = static_cast<size_t>(-1);
+
+  /// A callback taken from the queue to run.
+  struct Entry {
+    DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+    bool ordered = false;
+    PendingCallback call;
+  };
+
+  /**
+   * @brief A queued callback, linked into the lists by node index.
+   * @details Every node is in the arrival list. A runnable node is also in
+   *          the ready list, and an ordered node is in the list of its
+   *          instance. Free nodes are linked by nextReady.
+   */
+  struct Node {
+    DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+    bool ordered = false;
+    bool ready = false;
+    /// Set when the node is in the conflation index.
+    bool conflated = false;
+    PendingCallback call;
+    size_t older = Nil;
+    size_t newer = Nil;
+    size_t prevReady = Nil;
+    size_t nextReady = Nil;
+    size_t nextInstance = Nil;
+  };
+
+  /// The queued ordered callbacks of an instance, oldest first.
+  struct Instance {
+    size_t head = Nil;
+    size_t tail = Nil;
+    /// Set while a callback of the instance runs.
+    bool busy = false;
+  };
+
+  /// The instance and callback a CONFLATE node is replaced for.
+  struct ConflationKey {
+    DDS::InstanceHandle_t handle;
+    const GenericCallback* callback;
+
+    bool operator==(const ConflationKey& other) const
+    {
+      return handle == other.handle && callback == other.callback;
+    }
+  };
+
+  struct ConflationHash {
+    size_t operator()(const ConflationKey& key) const
+    {
+      return std::hash<DDS::InstanceHandle_t>()(key.handle) * 31 +
+             std::hash<const GenericCallback*>()(key.callback);
+    }
+  };
+
+  void schedule(OpenDDS::DCPS::RcHandle<DrainEvent> event)
+  {
+    auto executor = m_executor.lock();
+    if (executor) {
+      event->owner = shared_from_this();
+      if (executor->dispatch(event)) {
+        return;
+      }
+      event->owner.reset();
+    }
+
+    // Nothing will run the queued callbacks, so drop them rather than block
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      while (m_oldest != Nil) {
+        drop(m_oldest);
+        m_stats.dropped++;
+      }
+      m_drains--;
+      m_idleEvents.push_back(std::move(event));
+    }
+    m_notFull.notify_all();
+  }
+
+  /// A free node. Nodes are only added up to the capacity.
+  size_t allocate()
+  {
+    if (m_free == Nil) {
+      m_nodes.emplace_back();
+      return m_nodes.size() - 1;
+    }
+
+    const size_t index = m_free;
+    m_free = m_nodes[index].nextReady;
+    m_nodes[index] = Node();
+    return index;
+  }
+
+  /// Unlink a node from the arrival, ready and conflation lists and free it.
+  void release(size_t index)
+  {
+    Node& node = m_nodes[index];
+
+    if (node.older != Nil) {
+      m_nodes[node.older].newer = node.newer;
+    }
+    else {
+      m_oldest = node.newer;
+    }
+    if (node.newer != Nil) {
+      m_nodes[node.newer].older = node.older;
+    }
+    else {
+      m_newest = node.older;
+    }
+    m_size--;
+
+    if (node.ready) {
+      if (node.prevReady != Nil) {
+        m_nodes[node.prevReady].nextReady = node.nextReady;
+      }
+      else {
+        m_readyHead = node.nextReady;
+      }
+      if (node.nextReady != Nil) {
+        m_nodes[node.nextReady].prevReady = node.prevReady;
+      }
+      else {
+        m_readyTail = node.prevReady;
+      }
+    }
+
+    if (node.conflated) {
+      m_conflation.erase(ConflationKey{node.handle, node.call.callback.get()});
+    }
+
+    // Release the sample now rather than when the node is reused
+    node.call = PendingCallback();
+    node.nextReady = m_free;
+    m_free = index;
+  }
+
+  void makeReady(size_t index)
+  {
+    Node& node = m_nodes[index];
+    node.ready = true;
+    node.prevReady = m_readyTail;
+    node.nextReady = Nil;
+    if (m_readyTail != Nil) {
+      m_nodes[m_readyTail].nextReady = index;
+    }
+    else {
+      m_readyHead = index;
+    }
+    m_readyTail = index;
+  }
+
+  /// Take the oldest runnable callback, marking its instance busy.
+  bool popReady(Entry& entry)
+  {
+    const size_t index = m_readyHead;
+    if (index == Nil) {
+      return false;
+    }
+
+    Node& node = m_nodes[index];
+    entry.handle = node.handle;
+    entry.ordered = node.ordered;
+    entry.call = std::move(node.call);
+
+    if (node.ordered) {
+      Instance& instance = m_instances[node.handle];
+      instance.head = node.nextInstance;
+      if (instance.head == Nil) {
+        instance.tail = Nil;
+      }
+      instance.busy = true;
+    }
+
+    // The conflation key needs the callback, which was moved to the entry
+    if (node.conflated) {
+      m_conflation.erase(ConflationKey{node.handle, entry.call.callback.get()});
+      node.conflated = false;
+    }
+
+    release(index);
+    return true;
+  }
+
+  /// Let the next callback of an instance run once one has finished.
+  void finish(DDS::InstanceHandle_t handle)
+  {
+    auto iter = m_instances.find(handle);
+    if (iter == m_instances.end()) {
+      return;
+    }
+
+    iter->second.busy = false;
+    if (iter->second.head != Nil) {
+      makeReady(iter->second.head);
+    }
+    else {
+      m_instances.erase(iter);
+    }
+  }
+
+  /**
+   * @brief Discard the oldest callback.
+   * @remarks The oldest callback is always first in its instance, so it is
+   *          never queued behind another callback.
+   */
+  void drop(size_t index)
+  {
+    Node& node = m_nodes[index];
+    if (node.ordered) {
+      auto iter = m_instances.find(node.handle);
+      Instance& instance = iter->second;
+      instance.head = node.nextInstance;
+      if (instance.head == Nil) {
+        instance.tail = Nil;
+      }
+
+      if (!instance.busy) {
+        if (instance.head != Nil) {
+          makeReady(instance.head);
+        }
+        else {
+          m_instances.erase(iter);
+        }
+      }
+    }
+
+    release(index);
+  }
+
+  const size_t m_capacity;
+  const OverflowPolicy m_policy;
+  std::weak_ptr<CallbackExecutor> m_executor;
+
+  /// Drain events allowed at once, one per executor thread.
+  const size_t m_maxDrains;
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_notFull;
+
+  /// The queued and free callbacks, at most m_capacity.
+  std::vector<Node> m_nodes;
+
+  /// The arrival list, oldest first.
+  size_t m_oldest = Nil;
+  size_t m_newest = Nil;
+
+  /// Callbacks which can run now, oldest first.
+  size_t m_readyHead = Nil;
+  size_t m_readyTail = Nil;
+
+  size_t m_free = Nil;
+
+  /// Queued callbacks.
+  size_t m_size = 0;
+
+  /// Instances with ordered callbacks queued or running.
+  std::unordered_map<DDS::InstanceHandle_t, Instance> m_instances;
+
+  /// The queued callback of each instance and callback, with CONFLATE.
+  std::unordered_map<ConflationKey, size_t, ConflationHash> m_conflation;
+
+  /// Drain events dispatched or running.
+  size_t m_drains = 0;
+
+  /// Drain events which are not dispatched; at most m_maxDrains.
+  std::vector<OpenDDS::DCPS::RcHandle<DrainEvent>> m_idleEvents;
+
+  CallbackQueueStatistics m_stats;
+};
+
+void EmitterBase::setQueueLimit(size_t capacity, OverflowPolicy policy)
+{
+    std::shared_ptr<CallbackQueue> queue;
+    if (capacity > 0) {
+        queue = std::make_shared<CallbackQueue>(capacity, policy, m_executor);
+    }
+
+    // Callbacks in a replaced queue still run
+    std::shared_ptr<CallbackQueue> previous = std::atomic_exchange(&m_queue, queue);
+    if (previous) {
+        previous->wake();
+    }
+}
+
+CallbackQueueStatistics EmitterBase::getQueueStatistics() const
 {
-    auto dispatcher = m_dispatcher.lock();
-    if (dispatcher) {
-        dispatcher->dispatch(OpenDDS::DCPS::make_rch<std_fun_event>(fn));
+    std::shared_ptr<CallbackQueue> queue = std::atomic_load(&m_queue);
+    return queue ? queue->getStatistics() : CallbackQueueStatistics();
+}
+
+void EmitterBase::wakeQueue()
+{
+    std::shared_ptr<CallbackQueue> queue = std::atomic_load(&m_queue);
+    if (queue) {
+        queue->wake();
+    }
+}
+
+void EmitterBase::AddToThreadPool(std::function<void(void)> fn, DDS::InstanceHandle_t handle)
+{
+    PendingCallback call;
+    call.fn = std::move(fn);
+    post(std::move(call), handle);
+}
+
+void EmitterBase::AddToThreadPool(std::shared_ptr<GenericCallback> callback,
+                                  std::shared_ptr<const void> sample,
+                                  SharedInvoker invoke,
+                                  DDS::InstanceHandle_t handle)
+{
+    PendingCallback call;
+    call.callback = std::move(callback);
+    call.sample = std::move(sample);
+    call.invoke = invoke;
+    post(std::move(call), handle);
+}
+
+void EmitterBase::post(PendingCallback call, DDS::InstanceHandle_t handle)
+{
+    const bool ordered = m_instanceOrdering && handle != DDS::HANDLE_NIL;
+    std::shared_ptr<CallbackQueue> queue = std::atomic_load(&m_queue);
+    if (queue) {
+        queue->push(handle, ordered, std::move(call), m_stopping);
+        return;
+    }
+
+    if (ordered) {
+        m_strands->post(handle, std::move(call));
+        return;
+    }
+
+    if (m_executor) {
+        CallbackEventPool::dispatch(*m_executor, m_eventPool, std::move(call));
+    }
+}
+
+//------------------------------------------------------------------------------
+WaitSetReactor::WaitSetReactor(size_t threadCount) : m_running(true)
+{
+    const size_t count = threadCount > 0 ? threadCount : 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        std::unique_ptr<Shard> shard(new Shard);
+        shard->waitset = new DDS::WaitSet;
+        shard->wakeup = new DDS::GuardCondition;
+        shard->waitset->attach_condition(shard->wakeup);
+        m_shards.push_back(std::move(shard));
+    }
+
+    for (auto& shard : m_shards)
+    {
+        shard->thread = std::thread(&WaitSetReactor::run, this, std::ref(*shard));
+    }
+}
+
+//------------------------------------------------------------------------------
+WaitSetReactor::~WaitSetReactor()
+{
+    m_running = false;
+    for (auto& shard : m_shards)
+    {
+        shard->wakeup->set_trigger_value(true);
+    }
+
+    for (auto& shard : m_shards)
+    {
+        if (shard->thread.joinable())
+        {
+            shard->thread.join();
+        }
+        shard->waitset->detach_condition(shard->wakeup);
+    }
+}
+
+//------------------------------------------------------------------------------
+bool WaitSetReactor::attach(EmitterBase* emitter, DDS::DataReader_ptr reader)
+{
+    if (!emitter || !reader)
+    {
+        return false;
+    }
+
+    DDS::StatusCondition_var condition = reader->get_statuscondition();
+    if (!condition ||
+        condition->set_enabled_statuses(DDS::DATA_AVAILABLE_STATUS) != DDS::RETCODE_OK)
+    {
+        std::cerr << "Unable to enable the status condition of a reactor reader" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> attachLock(m_attachMutex);
+    if (m_attached.find(emitter) != m_attached.end())
+    {
+        return true;
+    }
+
+    // Use the thread with the fewest readers
+    Shard* shard = m_shards.front().get();
+    for (auto& candidate : m_shards)
+    {
+        if (candidate->load < shard->load)
+        {
+            shard = candidate.get();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        if (shard->waitset->attach_condition(condition) != DDS::RETCODE_OK)
+        {
+            std::cerr << "Unable to attach a reader to the reactor waitset" << std::endl;
+            return false;
+        }
+        shard->emitters[condition.in()] = emitter;
+    }
+
+    shard->load++;
+    m_attached[emitter] = std::make_pair(shard, condition);
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void WaitSetReactor::detach(EmitterBase* emitter)
+{
+    Shard* shard = nullptr;
+    DDS::StatusCondition_var condition;
+    {
+        std::lock_guard<std::mutex> attachLock(m_attachMutex);
+        auto iter = m_attached.find(emitter);
+        if (iter == m_attached.end())
+        {
+            return;
+        }
+
+        shard = iter->second.first;
+        condition = iter->second.second;
+        shard->load--;
+        m_attached.erase(iter);
+    }
+
+    std::unique_lock<std::mutex> lock(shard->mutex);
+    shard->waitset->detach_condition(condition);
+    shard->emitters.erase(condition.in());
+
+    // A callback may detach its own emitter; only wait on other threads
+    if (std::this_thread::get_id() != shard->thread.get_id())
+    {
+        shard->idle.wait(lock, [shard, emitter]() { return shard->dispatching != emitter; });
+    }
+}
+
+//------------------------------------------------------------------------------
+void WaitSetReactor::run(Shard& shard)
+{
+    DDS::Duration_t infinite;
+    infinite.sec = DDS::DURATION_INFINITE_SEC;
+    infinite.nanosec = DDS::DURATION_INFINITE_NSEC;
+
+    while (m_running)
+    {
+        DDS::ConditionSeq activeConditions;
+        if (shard.waitset->wait(activeConditions, infinite) != DDS::RETCODE_OK)
+        {
+            continue;
+        }
+
+        for (CORBA::ULong i = 0; i < activeConditions.length() && m_running; i++)
+        {
+            EmitterBase* emitter = nullptr;
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                auto iter = shard.emitters.find(activeConditions[i]);
+                if (iter == shard.emitters.end())
+                {
+                    continue;
+                }
+
+                emitter = iter->second;
+                shard.dispatching = emitter;
+            }
+
+            // No lock is held here, so callbacks can add or remove readers
+            emitter->readQueue();
+
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.dispatching = nullptr;
+            }
+            shard.idle.notify_all();
+        }
     }
 }
 
@@ -13,42 +13,156 @@
 #pragma warning(pop)
 #endif
 
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iostream>
 #include <typeinfo>
 #include <thread>
 #include <map>
-#include <typeindex>
 #include <future>
 #include <functional>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "dds_async_writer.h"
+#include "dds_executor.h"
+#include "dds_sample_batch.h"
 
 //This implementation was taken from the answer to stackoverflow question 16883817
 struct GenericCallback {
     virtual ~GenericCallback() { }
+    /// Set by the emitter the callback is added to, for removeCallback.
+    uint64_t id = 0;
 };
 
 template <typename TopicType>
 struct Callback : GenericCallback {
     std::function<void(const TopicType&)> function;
+    /// Set instead of function for callbacks which also receive the SampleInfo.
+    std::function<void(const TopicType&, const DDS::SampleInfo&)> infoFunction;
     Callback(std::function<void(const TopicType&)> fun) : function(fun) { }
+    Callback(std::function<void(const TopicType&, const DDS::SampleInfo&)> fun) : infoFunction(fun) { }
+};
+
+/// A callback which receives a whole take.
+template <typename TopicType>
+struct BatchCallback : GenericCallback {
+    std::function<void(const SampleBatch<TopicType>&)> function;
+    BatchCallback(std::function<void(const SampleBatch<TopicType>&)> fun) : function(fun) { }
+};
+
+/// Instance lifecycle callbacks. Either may be empty.
+template <typename TopicType>
+struct LifecycleCallback : GenericCallback {
+    std::function<void(const TopicType&)> disposedFunction;
+    std::function<void(const TopicType&)> noWritersFunction;
+    LifecycleCallback(std::function<void(const TopicType&)> onDisposed,
+                      std::function<void(const TopicType&)> onNoWriters) :
+        disposedFunction(onDisposed), noWritersFunction(onNoWriters) { }
+};
+
+/**
+ * @brief A copy of a sample and its SampleInfo for asynchronous callbacks.
+ * @details Made once per sample and shared by every asynchronous callback
+ *          of the sample, since the loan is returned before they run.
+ */
+template <typename TopicType>
+struct SharedSample {
+    const TopicType sample;
+    const DDS::SampleInfo info;
+    SharedSample(const TopicType& s, const DDS::SampleInfo& i) : sample(s), info(i) { }
+};
+
+/// A copy of a take shared by every asynchronous batch callback of the take.
+template <typename TopicType>
+struct SharedBatch {
+    typename SampleBatch<TopicType>::SampleSeq samples;
+    DDS::SampleInfoSeq infos;
+    SharedBatch(const typename SampleBatch<TopicType>::SampleSeq& s, const DDS::SampleInfoSeq& i) : infos(i)
+    {
+        // Copy element by element; a loaned sequence may not own its samples
+        samples.length(s.length());
+        for (CORBA::ULong n = 0; n < s.length(); n++) {
+            samples[n] = s[n];
+        }
+    }
 };
 
-typedef std::multimap<std::type_index, std::shared_ptr<GenericCallback> > Listeners;
+class WaitSetReactor;
+class InstanceStrands;
+class CallbackQueue;
+class CallbackEventPool;
+struct PendingCallback;
+
+/**
+ * @brief Counters of the bounded asynchronous callback queue of an emitter.
+ */
+struct CallbackQueueStatistics
+{
+    /// Callbacks accepted into the queue.
+    uint64_t enqueued = 0;
+    /// Callbacks discarded by the overflow policy or replaced by conflation.
+    uint64_t dropped = 0;
+    /// Callbacks which have run.
+    uint64_t executed = 0;
+    /// Callbacks waiting to run.
+    size_t depth = 0;
+    /// The most callbacks which were waiting at once.
+    size_t highWaterMark = 0;
+};
 
 class EmitterBase
 {
 public:
 
     /// Default constructor
-    EmitterBase(OpenDDS::DCPS::RcHandle<OpenDDS::DCPS::EventDispatcher> ed) : m_running(false), m_dispatcher(ed)
-    {}
+    EmitterBase(std::shared_ptr<CallbackExecutor> executor);
+
+    /// Identifies an added callback so it can be removed.
+    typedef uint64_t CallbackId;
 
     virtual ~EmitterBase();
 
     virtual void run() = 0;
     virtual void stop() = 0;
+
+    /**
+     * @brief Tell the emitter to stop without waiting for it.
+     * @details Call stop afterwards to wait. Signalling many emitters before
+     *          waiting on any of them lets them all wind down at once.
+     */
+    virtual void requestStop() = 0;
     virtual void readQueue() = 0;
     virtual void setReader(DDS::DataReader_var reader) = 0;
-    void AddToThreadPool(std::function<void(void)> fn);
+    /**
+     * @brief Queue a function on the executor threads.
+     * @param[in] fn The function to run.
+     * @param[in] handle The instance the function is for. With instance
+     *            ordering, functions of the same instance run in order.
+     */
+    void AddToThreadPool(std::function<void(void)> fn,
+                         DDS::InstanceHandle_t handle = DDS::HANDLE_NIL);
+
+    /// Calls a callback with a shared sample on an executor thread.
+    typedef void (*SharedInvoker)(const GenericCallback& callback, const void* sample);
+
+    /**
+     * @brief Queue a callback with a sample shared by other callbacks.
+     * @details Neither the callback nor the sample is copied. Like every
+     *          asynchronous callback of the emitter, it runs on an event
+     *          which is reused once it has run.
+     * @param[in] callback The callback, kept alive until it has run.
+     * @param[in] sample The shared sample passed to invoke.
+     * @param[in] invoke Casts the callback and sample back to their types.
+     * @param[in] handle The instance the sample belongs to.
+     */
+    void AddToThreadPool(std::shared_ptr<GenericCallback> callback,
+                         std::shared_ptr<const void> sample,
+                         SharedInvoker invoke,
+                         DDS::InstanceHandle_t handle = DDS::HANDLE_NIL);
 
     bool isRunning() const
     {
@@ -60,64 +174,195 @@ public:
         m_asyncEmitter = set;
     }
 
-    template <typename TopicType>
-    void addCallback(std::function<void(const TopicType&)> func)
+    /**
+     * @brief Run the asynchronous callbacks of each instance in order.
+     * @details Callbacks for samples of the same instance run one at a time,
+     *          in the order the samples were taken. Callbacks for different
+     *          instances still run in parallel on the executor threads.
+     *          Samples without an instance handle are not ordered.
+     */
+    void setInstanceOrdering(bool set)
     {
-        std::type_index index(typeid(TopicType));
-        std::shared_ptr<GenericCallback> func_ptr(new Callback<TopicType>(std::function<void(const TopicType&)>(func)));
-        m_callbacks.insert(Listeners::value_type(index, std::move(func_ptr)));
+        m_instanceOrdering = set;
     }
 
-    /// Sends a message out to anyone registered for that type
-    template <typename TopicType>
-    void emitMessage(TopicType& arg)
+    /**
+     * @brief Bound the asynchronous callbacks waiting to run.
+     * @details Without a bound, a consumer which falls behind makes the
+     *          executor queue grow without limit. With one, the policy
+     *          decides what happens to a new callback when the queue is full:
+     *          BLOCK stops the emitter from taking samples (so the reader's
+     *          history and reliability push back on the writers), DROP_OLDEST
+     *          and DROP_NEWEST discard a callback, and CONFLATE replaces the
+     *          queued callback for the same instance (or drops the new one
+     *          when there is none). Instance ordering is kept.
+     * @remarks BLOCK waits in readQueue while the samples of the take are
+     *          still on loan, and also holds up the other readers of a
+     *          shared reactor thread (see DDSManager::enableCallbackReactor).
+     *          A callback of this emitter which calls readQueue itself (such
+     *          as readCallbacks with queueMessages set) would wait on its own
+     *          queue, so its callbacks are dropped instead when it is full.
+     * @param[in] capacity The most callbacks waiting to run. Zero removes
+     *            the bound.
+     * @param[in] policy What to do with a callback when the queue is full.
+     */
+    void setQueueLimit(size_t capacity, OverflowPolicy policy);
+
+    /// The counters of the bounded queue. All zero without a bound.
+    CallbackQueueStatistics getQueueStatistics() const;
+
+    /**
+     * @brief Wait for data on a shared reactor thread instead of a thread
+     *        per emitter.
+     * @remarks Set before run is called.
+     */
+    void setReactor(std::shared_ptr<WaitSetReactor> reactor)
     {
-        std::type_index index(typeid(TopicType));
-        if (m_callbacks.count(index) > 0)
-        {
-            auto range = m_callbacks.equal_range(index);
-
-            for (auto it = range.first; it != range.second; ++it)
-            {
-                //Cast the generic function to the topic specific function and call with args
-                const GenericCallback &f = *it->second;
-                std::function<void(const TopicType&)> func = static_cast<const Callback<TopicType> &>(f).function;
-                if (m_asyncEmitter) {
-                    //Future destructor holds up execution
-                    //https://stackoverflow.com/questions/44654548/stdasync-doesnt-work-asynchronously
-                    //fut = std::async(std::launch::async, func, arg);
-                    AddToThreadPool([func, arg]() {func(arg);});
-                }
-                else {
-                    func(arg);
-                }
-            }
-        }
+        m_reactor = reactor;
     }
 
+    /**
+     * @brief Remove a callback.
+     * @details A callback already running, or queued in async mode, still
+     *          finishes.
+     * @param[in] id The id returned when the callback was added.
+     * @return True if the callback was found and removed; false otherwise.
+     */
+    virtual bool removeCallback(CallbackId id) = 0;
+
 protected:
 
-    // List of callbacks
-    std::multimap<std::type_index, std::shared_ptr<GenericCallback> > m_callbacks;
+    /// Wake the emitter if it is blocked on a full callback queue.
+    void wakeQueue();
+
+    /// Queue a callback on the bounded queue, its strand or the executor.
+    void post(PendingCallback call, DDS::InstanceHandle_t handle);
+
+    /// Serializes changes to the callbacks. Never taken while emitting.
+    std::mutex m_callbackMutex;
+
+    CallbackId m_nextCallbackId = 1;
 
     /// Flag to stop the thread.
-    bool m_running;
+    std::atomic<bool> m_running;
 
     bool m_asyncEmitter = false;
 
-    OpenDDS::DCPS::WeakRcHandle<OpenDDS::DCPS::EventDispatcher> m_dispatcher;
+    std::atomic<bool> m_instanceOrdering;
+
+    /// Queues per instance, used when m_instanceOrdering is set.
+    std::shared_ptr<InstanceStrands> m_strands;
+
+    /// Idle events of the unordered asynchronous callbacks.
+    std::shared_ptr<CallbackEventPool> m_eventPool;
+
+    /// The bounded callback queue, read with std::atomic_load. Null without a bound.
+    std::shared_ptr<CallbackQueue> m_queue;
+
+    /// Set by requestStop, so a blocked emitter drops instead of waiting.
+    std::atomic<bool> m_stopping;
+
+    /// Runs asynchronous callbacks. Kept even if DDSManager replaces it.
+    std::shared_ptr<CallbackExecutor> m_executor;
+
+    /// Dispatches this emitter when set; otherwise run starts a thread.
+    std::shared_ptr<WaitSetReactor> m_reactor;
 
     //std::future<void> fut;
 };
 
 
+/**
+ * @brief Waits for data on many data readers with a few threads.
+ *
+ * @details Each thread owns a WaitSet. The status conditions of attached
+ *          readers are spread over the threads, and a thread calls
+ *          EmitterBase::readQueue for each reader with data available. The
+ *          number of threads does not grow with the number of readers, and
+ *          idle threads block without a timeout.
+ */
+class WaitSetReactor
+{
+public:
+
+    /**
+     * @brief Start the reactor threads.
+     * @param[in] threadCount Number of threads (and WaitSets). At least one.
+     */
+    explicit WaitSetReactor(size_t threadCount);
+
+    /// Stops and joins the threads. Emitters must be detached first.
+    ~WaitSetReactor();
+
+    WaitSetReactor(const WaitSetReactor&) = delete;
+    WaitSetReactor& operator=(const WaitSetReactor&) = delete;
+
+    /**
+     * @brief Dispatch an emitter when its data reader has data available.
+     * @param[in] emitter The emitter whose readQueue is called.
+     * @param[in] reader The data reader of the emitter.
+     * @return True if the reader was attached; false otherwise.
+     */
+    bool attach(EmitterBase* emitter, DDS::DataReader_ptr reader);
+
+    /**
+     * @brief Stop dispatching an emitter.
+     * @details Waits for a readQueue call in progress on another thread, so
+     *          the emitter can be destroyed afterwards. Does nothing if the
+     *          emitter is not attached.
+     */
+    void detach(EmitterBase* emitter);
+
+    size_t threadCount() const
+    {
+        return m_shards.size();
+    }
+
+private:
+
+    struct Shard
+    {
+        DDS::WaitSet_var waitset;
+
+        /// Wakes the thread to stop.
+        DDS::GuardCondition_var wakeup;
+
+        /// Guards emitters and dispatching.
+        std::mutex mutex;
+        std::condition_variable idle;
+
+        /// The attached emitters, keyed by their status condition.
+        std::map<DDS::Condition_ptr, EmitterBase*> emitters;
+
+        /// The emitter whose readQueue is running.
+        EmitterBase* dispatching = nullptr;
+
+        /// Number of attached emitters, used to pick a shard (guarded by m_attachMutex).
+        size_t load = 0;
+
+        std::thread thread;
+    };
+
+    void run(Shard& shard);
+
+    std::vector<std::unique_ptr<Shard>> m_shards;
+
+    std::atomic<bool> m_running;
+
+    /// The shard and status condition of each attached emitter.
+    std::mutex m_attachMutex;
+    std::map<EmitterBase*, std::pair<Shard*, DDS::StatusCondition_var>> m_attached;
+};
+
+
 template <typename TopicType>
 class Emitter : public EmitterBase
 {
 public:
 
-    Emitter(DDS::DataReader_var const reader, OpenDDS::DCPS::RcHandle<OpenDDS::DCPS::EventDispatcher> ed) :
-            m_reader(reader), EmitterBase(ed)
+    Emitter(DDS::DataReader_var const reader, std::shared_ptr<CallbackExecutor> executor) :
+            m_reader(reader), EmitterBase(executor), m_wakeup(new DDS::GuardCondition),
+            m_callbacks(std::make_shared<const CallbackTable>())
     {
         if (!m_reader)
         {
@@ -137,18 +382,146 @@ public:
         m_topicType = tempstr.in();
     }
 
+    /**
+     * @brief Stops the emitter.
+     * @remarks Done here rather than in ~EmitterBase, since the reactor and
+     *          the listen thread call readQueue, which is gone by then.
+     */
+    ~Emitter()
+    {
+        stop();
+    }
+
+    /**
+     * @brief Add a callback for the samples of the topic.
+     * @remarks Callbacks can be added and removed while the emitter runs.
+     * @return The id to pass to removeCallback.
+     */
+    CallbackId addCallback(std::function<void(const TopicType&)> func)
+    {
+        return insertCallback(std::make_shared<Callback<TopicType>>(func), &CallbackTable::messages);
+    }
+
+    /// Add a callback which also receives the SampleInfo of each sample
+    CallbackId addCallback(std::function<void(const TopicType&, const DDS::SampleInfo&)> func)
+    {
+        return insertCallback(std::make_shared<Callback<TopicType>>(func), &CallbackTable::messages);
+    }
+
+    /**
+     * @brief Add a callback which receives every sample of a take at once.
+     * @details Called once per take, before the callbacks for the single
+     *          samples of the take. Samples of instances which are not alive
+     *          are included when lifecycle callbacks are added.
+     * @remarks Batches are not ordered per instance (see setInstanceOrdering).
+     * @return The id to pass to removeCallback.
+     */
+    CallbackId addBatchCallback(std::function<void(const SampleBatch<TopicType>&)> func)
+    {
+        return insertCallback(std::make_shared<BatchCallback<TopicType>>(func), &CallbackTable::batches);
+    }
+
+    /**
+     * @brief Add callbacks for instances which are disposed or lose all their writers.
+     * @details While any are added, the emitter also takes samples of
+     *          instances which are not alive, so these transitions are delivered.
+     * @param[in] onDisposed Called with the key of a disposed instance. May be empty.
+     * @param[in] onNoWriters Called with the key of an instance without writers. May be empty.
+     * @return The id to pass to removeCallback.
+     */
+    CallbackId addLifecycleCallback(std::function<void(const TopicType&)> onDisposed,
+                                    std::function<void(const TopicType&)> onNoWriters)
+    {
+        return insertCallback(std::make_shared<LifecycleCallback<TopicType>>(onDisposed, onNoWriters),
+                              &CallbackTable::lifecycles);
+    }
+
+    bool removeCallback(CallbackId id)
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+
+        auto callbacks = std::make_shared<CallbackTable>(*std::atomic_load(&m_callbacks));
+        if (!eraseCallback(callbacks->messages, id) &&
+            !eraseCallback(callbacks->batches, id) &&
+            !eraseCallback(callbacks->lifecycles, id))
+        {
+            return false;
+        }
+
+        std::atomic_store(&m_callbacks, std::shared_ptr<const CallbackTable>(std::move(callbacks)));
+        return true;
+    }
+
+    /// Sends a message out to the message callbacks
+    void emitMessage(TopicType& arg)
+    {
+        emitMessage(arg, DDS::SampleInfo());
+    }
+
+    /**
+     * @brief Sends a message and its SampleInfo out to the message callbacks
+     * @remarks Synchronous callbacks get references to the taken sample and
+     *          info. Asynchronous callbacks share one copy, since the loan is
+     *          returned before they run.
+     */
+    void emitMessage(TopicType& arg, const DDS::SampleInfo& info)
+    {
+        emitMessage(*std::atomic_load(&m_callbacks), arg, info);
+    }
+
+    /**
+     * @brief Sends a whole take out to the batch callbacks
+     * @remarks Synchronous callbacks view the taken sequences. Asynchronous
+     *          callbacks share one copy, since the loan is returned before
+     *          they run.
+     */
+    void emitBatch(const typename SampleBatch<TopicType>::SampleSeq& samples, const DDS::SampleInfoSeq& infos)
+    {
+        emitBatch(*std::atomic_load(&m_callbacks), samples, infos);
+    }
+
+    /**
+     * @brief Sends an instance lifecycle change out to the lifecycle callbacks
+     * @param[in] key Sample without valid data; only its key fields are set.
+     * @param[in] info The SampleInfo with the new instance state.
+     */
+    void emitLifecycle(TopicType& key, const DDS::SampleInfo& info)
+    {
+        emitLifecycle(*std::atomic_load(&m_callbacks), key, info);
+    }
+
     void run()
     {
+        m_stopping = false;
         if (!m_running) {
             m_running = true;
-            m_dataThread = std::thread(&Emitter::listen, this);
+            if (m_reactor) {
+                m_running = m_reactor->attach(this, m_reader);
+            }
+            else {
+                m_wakeup->set_trigger_value(false);
+                m_dataThread = std::thread(&Emitter::listen, this);
+            }
         }
     }
 
+    void requestStop()
+    {
+        m_running = false;
+        m_stopping = true;
+        m_wakeup->set_trigger_value(true);
+        wakeQueue();
+    }
+
     void stop()
     {
         // Wait for the thread to finish or we won't shutdown clean
-        m_running = false;
+        requestStop();
+        if (m_reactor)
+        {
+            m_reactor->detach(this);
+        }
+
         if (m_dataThread.joinable())
         {
             m_dataThread.join();
@@ -177,6 +550,14 @@ public:
             return;
         }
 
+        // Read once per take rather than per sample
+        const std::shared_ptr<const CallbackTable> callbacks = std::atomic_load(&m_callbacks);
+
+        // Lifecycle callbacks need the dispose and no writers samples too.
+        // Taking them leaves the instances without samples, so the reader
+        // can release them.
+        const bool lifecycle = !callbacks->lifecycles.empty();
+
         // Check for new data
         typename DDSTraits<TopicType>::MessageSequenceType msgList;
         DDS::SampleInfoSeq infoSeq;
@@ -186,7 +567,7 @@ public:
             DDS::LENGTH_UNLIMITED,
             DDS::ANY_SAMPLE_STATE,
             DDS::ANY_VIEW_STATE,
-            DDS::ALIVE_INSTANCE_STATE);
+            lifecycle ? DDS::ANY_INSTANCE_STATE : DDS::ALIVE_INSTANCE_STATE);
 
         if (status != DDS::RETCODE_OK && status != DDS::RETCODE_NO_DATA)
         {
@@ -201,10 +582,22 @@ public:
             return;
         }
 
+        if (msgList.length() > 0)
+        {
+            emitBatch(*callbacks, msgList, infoSeq);
+        }
+
         // Invoke the callback method for each received message
         for (int i = 0; i < (int)msgList.length(); i++)
         {
-            emitMessage(msgList[i]);
+            if (lifecycle && !infoSeq[i].valid_data)
+            {
+                emitLifecycle(*callbacks, msgList[i], infoSeq[i]);
+            }
+            else
+            {
+                emitMessage(*callbacks, msgList[i], infoSeq[i]);
+            }
         }
 
         dataReader->return_loan(msgList, infoSeq);
@@ -218,13 +611,160 @@ public:
 
 private:
 
+    /// The callbacks of each kind. Never modified once published.
+    struct CallbackTable
+    {
+        std::vector<std::shared_ptr<Callback<TopicType>>> messages;
+        std::vector<std::shared_ptr<BatchCallback<TopicType>>> batches;
+        std::vector<std::shared_ptr<LifecycleCallback<TopicType>>> lifecycles;
+    };
+
+    /// Publish a copy of the callbacks with one more callback of a kind.
+    template <typename Entry>
+    CallbackId insertCallback(std::shared_ptr<Entry> callback,
+                              std::vector<std::shared_ptr<Entry>> CallbackTable::* kind)
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+
+        callback->id = m_nextCallbackId++;
+        auto callbacks = std::make_shared<CallbackTable>(*std::atomic_load(&m_callbacks));
+        ((*callbacks).*kind).push_back(callback);
+
+        std::atomic_store(&m_callbacks, std::shared_ptr<const CallbackTable>(std::move(callbacks)));
+        return callback->id;
+    }
+
+    /// Remove the callback with an id from one kind of callbacks.
+    template <typename Entry>
+    static bool eraseCallback(std::vector<std::shared_ptr<Entry>>& callbacks, CallbackId id)
+    {
+        auto iter = std::find_if(callbacks.begin(), callbacks.end(),
+            [id](const std::shared_ptr<Entry>& callback) { return callback->id == id; });
+        if (iter == callbacks.end()) {
+            return false;
+        }
+
+        callbacks.erase(iter);
+        return true;
+    }
+
+    void emitMessage(const CallbackTable& callbacks, TopicType& arg, const DDS::SampleInfo& info)
+    {
+        // Copied on the first asynchronous callback only
+        std::shared_ptr<const SharedSample<TopicType>> shared;
+
+        for (const std::shared_ptr<Callback<TopicType>>& callback : callbacks.messages)
+        {
+            if (m_asyncEmitter) {
+                //Future destructor holds up execution
+                //https://stackoverflow.com/questions/44654548/stdasync-doesnt-work-asynchronously
+                if (!shared) {
+                    shared = std::make_shared<const SharedSample<TopicType>>(arg, info);
+                }
+                AddToThreadPool(callback, shared, &invokeMessage, info.instance_handle);
+            }
+            else if (callback->infoFunction) {
+                callback->infoFunction(arg, info);
+            }
+            else if (callback->function) {
+                callback->function(arg);
+            }
+        }
+    }
+
+    void emitBatch(const CallbackTable& callbacks,
+                   const typename SampleBatch<TopicType>::SampleSeq& samples,
+                   const DDS::SampleInfoSeq& infos)
+    {
+        // Copied on the first asynchronous callback only
+        std::shared_ptr<const SharedBatch<TopicType>> shared;
+
+        for (const std::shared_ptr<BatchCallback<TopicType>>& callback : callbacks.batches)
+        {
+            if (m_asyncEmitter) {
+                if (!shared) {
+                    shared = std::make_shared<const SharedBatch<TopicType>>(samples, infos);
+                }
+                AddToThreadPool(callback, shared, &invokeBatch);
+            }
+            else if (callback->function) {
+                callback->function(SampleBatch<TopicType>(samples, infos));
+            }
+        }
+    }
+
+    void emitLifecycle(const CallbackTable& callbacks, TopicType& key, const DDS::SampleInfo& info)
+    {
+        const bool disposed = info.instance_state == DDS::NOT_ALIVE_DISPOSED_INSTANCE_STATE;
+        if (!disposed && info.instance_state != DDS::NOT_ALIVE_NO_WRITERS_INSTANCE_STATE) {
+            return;
+        }
+
+        // Copied on the first asynchronous callback only
+        std::shared_ptr<const TopicType> shared;
+
+        for (const std::shared_ptr<LifecycleCallback<TopicType>>& callback : callbacks.lifecycles)
+        {
+            const std::function<void(const TopicType&)>& func =
+                disposed ? callback->disposedFunction : callback->noWritersFunction;
+            if (!func) {
+                continue;
+            }
+
+            if (m_asyncEmitter) {
+                if (!shared) {
+                    shared = std::make_shared<const TopicType>(key);
+                }
+                AddToThreadPool(callback, shared, disposed ? &invokeDisposed : &invokeNoWriters,
+                                info.instance_handle);
+            }
+            else {
+                func(key);
+            }
+        }
+    }
+
+    /// The SharedInvoker of message callbacks.
+    static void invokeMessage(const GenericCallback& f, const void* sample)
+    {
+        const Callback<TopicType>& callback = static_cast<const Callback<TopicType>&>(f);
+        const SharedSample<TopicType>& shared = *static_cast<const SharedSample<TopicType>*>(sample);
+        if (callback.infoFunction) {
+            callback.infoFunction(shared.sample, shared.info);
+        }
+        else if (callback.function) {
+            callback.function(shared.sample);
+        }
+    }
+
+    /// The SharedInvoker of batch callbacks.
+    static void invokeBatch(const GenericCallback& f, const void* batch)
+    {
+        const BatchCallback<TopicType>& callback = static_cast<const BatchCallback<TopicType>&>(f);
+        const SharedBatch<TopicType>& shared = *static_cast<const SharedBatch<TopicType>*>(batch);
+        callback.function(SampleBatch<TopicType>(shared.samples, shared.infos));
+    }
+
+    /// The SharedInvoker of disposed instances.
+    static void invokeDisposed(const GenericCallback& f, const void* key)
+    {
+        static_cast<const LifecycleCallback<TopicType>&>(f).disposedFunction(*static_cast<const TopicType*>(key));
+    }
+
+    /// The SharedInvoker of instances without writers.
+    static void invokeNoWriters(const GenericCallback& f, const void* key)
+    {
+        static_cast<const LifecycleCallback<TopicType>&>(f).noWritersFunction(*static_cast<const TopicType*>(key));
+    }
+
     void listen()
     {
         using OpenDDS::DCPS::DDSTraits;
 
+        // Only new data or requestStop wake this thread
         DDS::Duration_t waitTimeout;
-        waitTimeout.sec = 0;
-        waitTimeout.nanosec = 10000000; // 10 millis
+        waitTimeout.sec = DDS::DURATION_INFINITE_SEC;
+        waitTimeout.nanosec = DDS::DURATION_INFINITE_NSEC;
 
         DDS::ReturnCode_t status = DDS::RETCODE_OK;
         DDS::WaitSet waitset;
@@ -282,6 +822,19 @@ private:
             return;
         }
 
+        status = waitset.attach_condition(m_wakeup);
+        if (status != DDS::RETCODE_OK)
+        {
+            std::cerr << "Unable to assign waitset guard condition on '"
+                      << m_topicName
+                      << "' of type '"
+                      << m_topicType
+                      << "'"
+                      << std::endl;
+            waitset.detach_condition(statusCondition);
+            return;
+        }
+
 
         // Loop until the parent of this thread stops
         while (m_running)
@@ -289,7 +842,7 @@ private:
             // Block this thread for new data
             DDS::ConditionSeq activeConditions;
             status = waitset.wait(activeConditions, waitTimeout);
-            if (status != DDS::RETCODE_OK)
+            if (status != DDS::RETCODE_OK || !m_running)
             {
                 continue;
             }
@@ -297,6 +850,9 @@ private:
             readQueue();
         }
 
+        waitset.detach_condition(m_wakeup);
+        waitset.detach_condition(statusCondition);
+
         if (m_reader) {
             m_reader = DDS::DataReader::_nil();
         }
@@ -315,6 +871,12 @@ private:
     /// The data reader thread
     std::thread m_dataThread;
 
+    /// Triggered by requestStop to wake the data reader thread.
+    DDS::GuardCondition_var m_wakeup;
+
+    /// The callbacks, read with std::atomic_load and replaced under m_callbackMutex.
+    std::shared_ptr<const CallbackTable> m_callbacks;
+
 };
 
 
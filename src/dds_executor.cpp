@@ -0,0 +1,279 @@
+#include "dds_executor.h"
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/ServiceEventDispatcher.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#if defined(WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+namespace {
+
+/// The executor state and queue of the current worker thread.
+thread_local const void* t_executor = nullptr;
+thread_local size_t t_worker = 0;
+
+/// Name and pin the current thread. Failures are ignored.
+void configureThread(const std::string& name, int cpu)
+{
+#if defined(WIN32)
+    const std::wstring wideName(name.begin(), name.end());
+    SetThreadDescription(GetCurrentThread(), wideName.c_str());
+    if (cpu >= 0) {
+        SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+    }
+#elif defined(__APPLE__)
+    pthread_setname_np(name.substr(0, 63).c_str());
+    (void)cpu;
+#else
+    pthread_setname_np(pthread_self(), name.substr(0, 15).c_str());
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+}
+
+}
+
+//------------------------------------------------------------------------------
+DispatcherExecutor::DispatcherExecutor(size_t threadCount) :
+    m_dispatcher(OpenDDS::DCPS::make_rch<OpenDDS::DCPS::ServiceEventDispatcher>(threadCount)),
+    m_threadCount(threadCount),
+    m_dispatched(0)
+{}
+
+//------------------------------------------------------------------------------
+DispatcherExecutor::~DispatcherExecutor()
+{
+    shutdown();
+}
+
+//------------------------------------------------------------------------------
+bool DispatcherExecutor::dispatch(OpenDDS::DCPS::EventBase_rch event)
+{
+    if (!m_dispatcher->dispatch(event))
+    {
+        return false;
+    }
+
+    m_dispatched++;
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void DispatcherExecutor::shutdown()
+{
+    m_dispatcher->shutdown();
+}
+
+//------------------------------------------------------------------------------
+ExecutorStatistics DispatcherExecutor::getStatistics() const
+{
+    ExecutorStatistics stats;
+    stats.threads = m_threadCount;
+    stats.dispatched = m_dispatched;
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+WorkStealingExecutor::WorkStealingExecutor(const WorkStealingOptions& options) :
+    m_state(std::make_shared<State>())
+{
+    const size_t count = options.threadCount > 0 ? options.threadCount : 1;
+    for (size_t i = 0; i < count; i++)
+    {
+        m_state->workers.push_back(std::unique_ptr<Worker>(new Worker));
+    }
+
+    // Start the threads once every queue exists, since workers steal
+    for (size_t i = 0; i < count; i++)
+    {
+        const int cpu = options.cpus.empty() ? -1 : options.cpus[i % options.cpus.size()];
+        m_state->workers[i]->thread = std::thread(&WorkStealingExecutor::run, m_state, i, options.name + std::to_string(i), cpu);
+    }
+}
+
+//------------------------------------------------------------------------------
+WorkStealingExecutor::~WorkStealingExecutor()
+{
+    shutdown();
+}
+
+//------------------------------------------------------------------------------
+bool WorkStealingExecutor::dispatch(OpenDDS::DCPS::EventBase_rch event)
+{
+    State& state = *m_state;
+    if (!state.running || !event)
+    {
+        return false;
+    }
+
+    // Keep events from a worker on its own queue, since they usually follow
+    // the event it is running
+    const size_t index = t_executor == &state ? t_worker : state.next++ % state.workers.size();
+    Worker& worker = *state.workers[index];
+
+    // Counted before it is queued, so the count never drops below zero
+    const size_t pending = ++state.pending;
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.events.push_back(event);
+    }
+
+    size_t max = state.maxPending;
+    while (pending > max && !state.maxPending.compare_exchange_weak(max, pending)) {}
+    state.dispatched++;
+
+    // Only take the lock when a worker may be waiting on it
+    if (state.sleeping > 0)
+    {
+        {
+            std::lock_guard<std::mutex> lock(state.sleepMutex);
+        }
+        state.wakeup.notify_one();
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------
+void WorkStealingExecutor::shutdown()
+{
+    State& state = *m_state;
+    std::lock_guard<std::mutex> shutdownLock(state.shutdownMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(state.sleepMutex);
+        state.running = false;
+    }
+    state.wakeup.notify_all();
+
+    for (auto& worker : state.workers)
+    {
+        if (!worker->thread.joinable())
+        {
+            continue;
+        }
+
+        // A callback may shut down or destroy its own executor. It can't join
+        // itself, and its thread keeps the state alive until it returns.
+        if (worker->thread.get_id() == std::this_thread::get_id())
+        {
+            worker->thread.detach();
+        }
+        else
+        {
+            worker->thread.join();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+ExecutorStatistics WorkStealingExecutor::getStatistics() const
+{
+    const State& state = *m_state;
+
+    ExecutorStatistics stats;
+    stats.threads = state.workers.size();
+    stats.dispatched = state.dispatched;
+    stats.executed = state.executed;
+    stats.steals = state.steals;
+    stats.queueDepth = state.pending;
+    stats.maxQueueDepth = state.maxPending;
+
+    stats.workerQueueDepths.reserve(state.workers.size());
+    for (const auto& worker : state.workers)
+    {
+        std::lock_guard<std::mutex> lock(worker->mutex);
+        stats.workerQueueDepths.push_back(worker->events.size());
+    }
+
+    return stats;
+}
+
+//------------------------------------------------------------------------------
+void WorkStealingExecutor::run(std::shared_ptr<State> state, size_t index, const std::string& name, int cpu)
+{
+    t_executor = state.get();
+    t_worker = index;
+    configureThread(name, cpu);
+
+    Worker& worker = *state->workers[index];
+    while (true)
+    {
+        OpenDDS::DCPS::EventBase_rch event;
+        if (popLocal(worker, event) || steal(*state, index, event))
+        {
+            state->pending--;
+            event->handle_event();
+            state->executed++;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(state->sleepMutex);
+        if (!state->running && state->pending == 0)
+        {
+            break;
+        }
+
+        state->sleeping++;
+        state->wakeup.wait(lock, [&state]() { return state->pending > 0 || !state->running; });
+        state->sleeping--;
+    }
+
+    t_executor = nullptr;
+}
+
+//------------------------------------------------------------------------------
+bool WorkStealingExecutor::popLocal(Worker& worker, OpenDDS::DCPS::EventBase_rch& event)
+{
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    if (worker.events.empty())
+    {
+        return false;
+    }
+
+    event = worker.events.front();
+    worker.events.pop_front();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+bool WorkStealingExecutor::steal(State& state, size_t thief, OpenDDS::DCPS::EventBase_rch& event)
+{
+    if (state.pending == 0)
+    {
+        return false;
+    }
+
+    for (size_t i = 1; i < state.workers.size(); i++)
+    {
+        Worker& victim = *state.workers[(thief + i) % state.workers.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.events.empty())
+        {
+            event = victim.events.back();
+            victim.events.pop_back();
+            state.steals++;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @}
+ */
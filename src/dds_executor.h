@@ -0,0 +1,206 @@
+#ifndef __DDS_EXECUTOR_H__
+#define __DDS_EXECUTOR_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/EventDispatcher.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Counters of a callback executor.
+ */
+struct ExecutorStatistics
+{
+    /// Worker threads.
+    size_t threads = 0;
+    /// Events accepted by dispatch.
+    uint64_t dispatched = 0;
+    /// Events which have run.
+    uint64_t executed = 0;
+    /// Events a worker took from the queue of another worker.
+    uint64_t steals = 0;
+    /// Events waiting to run.
+    size_t queueDepth = 0;
+    /// The most events which were waiting at once.
+    size_t maxQueueDepth = 0;
+    /// Events waiting in the queue of each worker.
+    std::vector<size_t> workerQueueDepths;
+};
+
+
+/**
+ * @brief Runs asynchronous callbacks.
+ *
+ * @details Emitters dispatch the callbacks of readers added with
+ *          asyncHandling to an executor. DDSManager creates a default
+ *          executor; others can be assigned to the whole manager or to single
+ *          topics (see DDSManager::setCallbackExecutor), so slow consumers on
+ *          one topic do not delay the callbacks of another.
+ */
+class CallbackExecutor
+{
+public:
+
+    virtual ~CallbackExecutor() {}
+
+    /**
+     * @brief Run an event on a worker thread.
+     * @return True if the event was queued; false if the executor is shut down.
+     */
+    virtual bool dispatch(OpenDDS::DCPS::EventBase_rch event) = 0;
+
+    /// Run the queued events, then stop the worker threads.
+    virtual void shutdown() = 0;
+
+    virtual ExecutorStatistics getStatistics() const = 0;
+};
+
+
+/**
+ * @brief Runs callbacks on an OpenDDS ServiceEventDispatcher.
+ * @remarks The default executor. The dispatcher does not report its queue,
+ *          so only the dispatched events are counted.
+ */
+class DispatcherExecutor : public CallbackExecutor
+{
+public:
+
+    explicit DispatcherExecutor(size_t threadCount);
+
+    ~DispatcherExecutor();
+
+    bool dispatch(OpenDDS::DCPS::EventBase_rch event);
+
+    void shutdown();
+
+    ExecutorStatistics getStatistics() const;
+
+private:
+
+    OpenDDS::DCPS::RcHandle<OpenDDS::DCPS::EventDispatcher> m_dispatcher;
+
+    size_t m_threadCount;
+
+    std::atomic<uint64_t> m_dispatched;
+};
+
+
+/**
+ * @brief Options of a WorkStealingExecutor.
+ */
+struct WorkStealingOptions
+{
+    /// Worker threads. At least one.
+    size_t threadCount = 4;
+
+    /// Worker threads are named this followed by their index. Platforms
+    /// limit thread names (15 characters on Linux), so keep it short.
+    std::string name = "ddw-cb";
+
+    /// If not empty, worker i is pinned to CPU cpus[i % cpus.size()]. Not
+    /// supported on macOS.
+    std::vector<int> cpus;
+};
+
+
+/**
+ * @brief Runs callbacks on workers which each have their own queue.
+ *
+ * @details An event dispatched from a worker thread (such as a strand
+ *          continuing itself) goes to that worker's queue. Other events are
+ *          spread over the queues in turn. A worker runs the events of its own
+ *          queue in order and, once it is empty, steals the newest event of
+ *          another queue, so a burst on one queue is shared by idle workers
+ *          without every dispatch contending on a single queue.
+ */
+class WorkStealingExecutor : public CallbackExecutor
+{
+public:
+
+    explicit WorkStealingExecutor(const WorkStealingOptions& options = WorkStealingOptions());
+
+    /**
+     * @brief Runs the queued events and joins the workers.
+     * @remarks May run on a worker, when a callback drops the last reference
+     *          to the executor. That worker is detached instead of joined,
+     *          and finishes with the queues it shares with the others.
+     */
+    ~WorkStealingExecutor();
+
+    WorkStealingExecutor(const WorkStealingExecutor&) = delete;
+    WorkStealingExecutor& operator=(const WorkStealingExecutor&) = delete;
+
+    bool dispatch(OpenDDS::DCPS::EventBase_rch event);
+
+    void shutdown();
+
+    ExecutorStatistics getStatistics() const;
+
+private:
+
+    struct Worker
+    {
+        mutable std::mutex mutex;
+        std::deque<OpenDDS::DCPS::EventBase_rch> events;
+        std::thread thread;
+    };
+
+    /// The queues and counters, owned by the executor and every worker thread.
+    struct State
+    {
+        std::vector<std::unique_ptr<Worker>> workers;
+
+        std::atomic<bool> running{true};
+
+        /// Queued events of all workers.
+        std::atomic<size_t> pending{0};
+
+        /// Workers waiting on wakeup.
+        std::atomic<size_t> sleeping{0};
+
+        /// The next queue for an event dispatched outside the workers.
+        std::atomic<size_t> next{0};
+
+        std::mutex sleepMutex;
+        std::condition_variable wakeup;
+
+        /// Serializes shutdown.
+        std::mutex shutdownMutex;
+
+        std::atomic<uint64_t> dispatched{0};
+        std::atomic<uint64_t> executed{0};
+        std::atomic<uint64_t> steals{0};
+        std::atomic<size_t> maxPending{0};
+    };
+
+    static void run(std::shared_ptr<State> state, size_t index, const std::string& name, int cpu);
+
+    /// Take the oldest event of a worker's own queue.
+    static bool popLocal(Worker& worker, OpenDDS::DCPS::EventBase_rch& event);
+
+    /// Take the newest event of another worker's queue.
+    static bool steal(State& state, size_t thief, OpenDDS::DCPS::EventBase_rch& event);
+
+    std::shared_ptr<State> m_state;
+};
+
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,183 @@
+#ifndef __DDS_LAST_VALUE_CACHE_H__
+#define __DDS_LAST_VALUE_CACHE_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/TypeSupportImpl.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief The latest sample of every instance of a topic.
+ *
+ * @details Filled by the reader thread of a data reader (see
+ *          DDSManager::createLastValueCache) and queried by any number of
+ *          threads. Lookups never take the lock used by the reader thread:
+ *          the key index is split into shards by key hash, each an immutable
+ *          map replaced as a whole when one of its instances is added or
+ *          removed, and each instance holds its latest sample in a shared
+ *          pointer which is swapped atomically. Only one shard is copied per
+ *          added or removed instance, so topics with many short lived
+ *          instances stay cheap to update. A reader keeps the
+ *          sample it got even if a newer one arrives.
+ *
+ *          The version counter increases with every update, so a thread can
+ *          poll version() and only look up values when it changed.
+ */
+template <typename TopicType>
+class LastValueCache
+{
+public:
+
+    typedef std::shared_ptr<const TopicType> ValuePtr;
+
+    LastValueCache() :
+        m_size(0), m_version(0)
+    {
+        for (auto& shard : m_shards)
+        {
+            shard = std::make_shared<const Index>();
+        }
+    }
+
+    LastValueCache(const LastValueCache&) = delete;
+    LastValueCache& operator=(const LastValueCache&) = delete;
+
+    /**
+     * @brief Get the latest sample of an instance.
+     * @param[in] key A sample whose key fields select the instance. The
+     *            other fields are ignored.
+     * @return The latest sample, or nullptr if the instance was never seen.
+     */
+    ValuePtr get(const TopicType& key) const;
+
+    /**
+     * @brief Get the latest sample of every instance.
+     * @remarks Each sample is the latest at the time it is visited; samples
+     *          of different instances may be from different updates.
+     */
+    std::vector<ValuePtr> snapshot() const
+    {
+        std::vector<ValuePtr> values;
+        values.reserve(size());
+        for (const auto& shard : m_shards)
+        {
+            const std::shared_ptr<const Index> index = std::atomic_load(&shard);
+            for (const auto& entry : *index)
+            {
+                ValuePtr value = std::atomic_load(&entry.second->value);
+                if (value)
+                {
+                    values.push_back(std::move(value));
+                }
+            }
+        }
+
+        return values;
+    }
+
+    /// Increases every time a sample is stored.
+    uint64_t version() const
+    {
+        return m_version.load(std::memory_order_acquire);
+    }
+
+    /// The number of instances seen.
+    size_t size() const
+    {
+        return m_size.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief Store a received sample as the latest value of its instance.
+     * @remarks Called by the reader thread. A sample of an instance which is
+     *          disposed or has no writers removes the instance instead.
+     *          Other samples without valid data are ignored.
+     * @param[in] sample The received sample.
+     * @param[in] info The SampleInfo of the sample.
+     */
+    void update(const TopicType& sample, const DDS::SampleInfo& info);
+
+    /**
+     * @brief Forget an instance, such as one which was disposed.
+     * @remarks Called by the reader thread. Threads which already got the
+     *          latest sample of the instance keep it.
+     * @param[in] key A sample whose key fields select the instance.
+     * @param[in] handle The instance handle of the key, if known.
+     */
+    void erase(const TopicType& key, DDS::InstanceHandle_t handle = DDS::HANDLE_NIL);
+
+    /// Forget all instances.
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_updateMutex);
+        m_handleSlots.clear();
+        for (auto& shard : m_shards)
+        {
+            std::atomic_store(&shard, std::make_shared<const Index>());
+        }
+        m_size.store(0, std::memory_order_release);
+        m_version.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+
+    struct Slot
+    {
+        /// The serialized key, kept to detect hash collisions.
+        std::string key;
+        /// The instance handle the slot is listed under in m_handleSlots.
+        DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+        /// Swapped with std::atomic_store by the reader thread.
+        ValuePtr value;
+    };
+
+    /// The key is the hash of the serialized instance key.
+    typedef std::unordered_multimap<uint64_t, std::shared_ptr<Slot>> Index;
+
+    /// Index shards, selected by key hash.
+    static constexpr size_t ShardCount = 128;
+
+    /// The shard of a key hash.
+    std::shared_ptr<const Index>& shardOf(uint64_t hash)
+    {
+        return m_shards[hash % ShardCount];
+    }
+
+    const std::shared_ptr<const Index>& shardOf(uint64_t hash) const
+    {
+        return m_shards[hash % ShardCount];
+    }
+
+    /// Immutable once published; replaced when an instance is added or removed.
+    std::shared_ptr<const Index> m_shards[ShardCount];
+
+    /// Instances in all shards.
+    std::atomic<size_t> m_size;
+
+    std::atomic<uint64_t> m_version;
+
+    /// Serializes updates. Never taken by lookups.
+    std::mutex m_updateMutex;
+
+    /// Slots by instance handle, so updates only serialize new keys.
+    std::unordered_map<DDS::InstanceHandle_t, std::shared_ptr<Slot>> m_handleSlots;
+};
+
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,130 @@
+#ifndef __DDS_LOANED_SAMPLES_H__
+#define __DDS_LOANED_SAMPLES_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/TypeSupportImpl.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include "dds_sample_iterator.h"
+
+#include <memory>
+
+/**
+ * @brief Samples loaned by a data reader, returned when the view is destroyed.
+ *
+ * @details Returned by DDSManager::takeLoaned and DDSManager::readLoaned. The
+ *          samples and their SampleInfo are exposed by reference straight
+ *          from the loaned sequences, so large samples are never copied. The
+ *          loan is returned to the data reader in the destructor or by
+ *          calling returnLoan. The view can be moved but not copied.
+ * @remarks Samples with SampleInfo::valid_data set to false (such as
+ *          dispose notifications) only have their key fields set.
+ */
+template <typename TopicType>
+class LoanedSamples
+{
+public:
+
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::DataReaderType::_var_type ReaderVar;
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::MessageSequenceType SampleSeq;
+
+    /// Iterates over the samples of the loan.
+    typedef SampleIterator<LoanedSamples, TopicType> const_iterator;
+
+    /// Creates an empty view.
+    LoanedSamples() = default;
+
+    /// Creates an empty view which will hold a loan from this reader.
+    explicit LoanedSamples(ReaderVar reader) :
+        m_loan(std::make_unique<Loan>())
+    {
+        m_loan->reader = reader;
+    }
+
+    ~LoanedSamples()
+    {
+        returnLoan();
+    }
+
+    LoanedSamples(const LoanedSamples&) = delete;
+    LoanedSamples& operator=(const LoanedSamples&) = delete;
+
+    LoanedSamples(LoanedSamples&& other) noexcept = default;
+
+    LoanedSamples& operator=(LoanedSamples&& other) noexcept
+    {
+        if (this != &other)
+        {
+            returnLoan();
+            m_loan = std::move(other.m_loan);
+        }
+        return *this;
+    }
+
+    /// The number of loaned samples.
+    size_t size() const
+    {
+        return m_loan ? m_loan->samples.length() : 0;
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /// The sample at an index. The index must be less than size().
+    const TopicType& operator[](size_t index) const
+    {
+        return m_loan->samples[static_cast<CORBA::ULong>(index)];
+    }
+
+    /// The SampleInfo of the sample at an index.
+    const DDS::SampleInfo& info(size_t index) const
+    {
+        return m_loan->infos[static_cast<CORBA::ULong>(index)];
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+    /**
+     * @brief Return the loan to the data reader before the view is destroyed.
+     * @remarks The view is empty afterwards.
+     */
+    void returnLoan();
+
+    /// The sequences filled in by take or read (used by DDSManager).
+    SampleSeq& samples() { return m_loan->samples; }
+    DDS::SampleInfoSeq& infos() { return m_loan->infos; }
+
+private:
+
+    /// Kept on the heap so the view can be moved without moving the sequences.
+    struct Loan
+    {
+        ReaderVar reader;
+        SampleSeq samples;
+        DDS::SampleInfoSeq infos;
+    };
+
+    std::unique_ptr<Loan> m_loan;
+};
+
+#endif
+
+/**
+ * @}
+ */
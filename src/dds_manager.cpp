@@ -20,7 +20,6 @@
 #endif
 #include <dds/DCPS/Service_Participant.h>
 #include <dds/DCPS/RTPS/RtpsDiscovery.h>
-#include <dds/DCPS/ServiceEventDispatcher.h>
 #include <dds/DCPS/DataWriterImpl.h>
 #include <dds/DCPS/DataReaderImpl.h>
 #include <dds/DCPS/LogAddr.h>
@@ -34,6 +33,7 @@
 #include <sstream>
 #include <cstdlib>
 #include <future>
+#include <unordered_map>
 
 #include "platformIndependent.h"
 #include "std_qosC.h"
@@ -87,7 +87,8 @@ DDSManager::DDSManager(std::function<void(LogMessageType mt, const std::string&
 
     //Register to get ace messages
     ACE::init();
-    m_dispatcher = OpenDDS::DCPS::make_rch<OpenDDS::DCPS::ServiceEventDispatcher>(threadPoolSize);
+    m_executor = std::make_shared<DispatcherExecutor>(threadPoolSize);
+    m_ownsExecutor = true;
 
     QosDictionary::getDataRepresentationType();
     QosDictionary::getTimestampPolicy();
@@ -186,8 +187,13 @@ DDSManager::~DDSManager()
 
     m_domainParticipant = nullptr;
 
-    m_dispatcher->shutdown();
-    m_dispatcher.reset();
+    // Executors set by the user may be shared with other managers
+    if (m_ownsExecutor)
+    {
+        m_executor->shutdown();
+    }
+    m_executor.reset();
+    m_topicExecutors.clear();
 
 } // End DDSManager::~DDSManager
 
@@ -578,6 +584,339 @@ bool DDSManager::unregisterTopic(const std::string& topicName)
 }
 
 
+//------------------------------------------------------------------------------
+bool DDSManager::enableInstanceCache(const std::string& topicName,
+    const bool& enable)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    // Make sure this topic has been registered
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        std::cerr << "Error enabling the instance cache for '"
+            << topicName
+            << "'. The topic has not been registered."
+            << std::endl;
+
+        return false;
+    }
+
+    iter->second->useInstanceCache = enable;
+    if (iter->second->writerState)
+    {
+        iter->second->writerState->instanceCache.enable(enable);
+    }
+
+    for (auto& state : iter->second->writerStates)
+    {
+        state.second->instanceCache.enable(enable);
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::enableChangeSuppression(const std::string& topicName,
+    const bool& enable)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    // Make sure this topic has been registered
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        std::cerr << "Error enabling change suppression for '"
+            << topicName
+            << "'. The topic has not been registered."
+            << std::endl;
+
+        return false;
+    }
+
+    iter->second->suppressUnchanged = enable;
+    if (iter->second->writerState)
+    {
+        iter->second->writerState->changeFilter.enable(enable);
+    }
+
+    for (auto& state : iter->second->writerStates)
+    {
+        state.second->changeFilter.enable(enable);
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::setAsyncWriteOptions(const std::string& topicName,
+    const size_t& capacity,
+    const OverflowPolicy& policy)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    // Make sure this topic has been registered
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        std::cerr << "Error setting the async write options for '"
+            << topicName
+            << "'. The topic has not been registered."
+            << std::endl;
+
+        return false;
+    }
+
+    if (iter->second->asyncWriter)
+    {
+        std::cerr << "Error setting the async write options for '"
+            << topicName
+            << "'. The async write queue already exists."
+            << std::endl;
+
+        return false;
+    }
+
+    if (capacity == 0)
+    {
+        std::cerr << "Error setting the async write options for '"
+            << topicName
+            << "'. The capacity must be greater than zero."
+            << std::endl;
+
+        return false;
+    }
+
+    iter->second->asyncCapacity = capacity;
+    iter->second->asyncPolicy = policy;
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::enableConflation(const std::string& topicName,
+    const double& maxFlushRate,
+    const size_t& maxInstances)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    // Make sure this topic has been registered
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        std::cerr << "Error enabling conflation for '"
+            << topicName
+            << "'. The topic has not been registered."
+            << std::endl;
+
+        return false;
+    }
+
+    std::shared_ptr<TopicGroup> topicGroup = iter->second;
+    if (topicGroup->asyncWriter)
+    {
+        std::cerr << "Error enabling conflation for '"
+            << topicName
+            << "'. The async write queue already exists."
+            << std::endl;
+
+        return false;
+    }
+
+    // Dropping intermediate samples is only safe if readers would too
+    if (topicGroup->dataWriterQos.history.kind != DDS::KEEP_LAST_HISTORY_QOS ||
+        topicGroup->dataWriterQos.history.depth != 1)
+    {
+        std::cerr << "Error enabling conflation for '"
+            << topicName
+            << "'. The writer QoS must keep only the last sample (KEEP_LAST, depth 1)."
+            << std::endl;
+
+        return false;
+    }
+
+    if (maxFlushRate < 0.0 || maxInstances == 0)
+    {
+        std::cerr << "Error enabling conflation for '"
+            << topicName
+            << "'. Invalid flush rate or instance limit."
+            << std::endl;
+
+        return false;
+    }
+
+    topicGroup->asyncCapacity = maxInstances;
+    topicGroup->asyncPolicy = OverflowPolicy::CONFLATE;
+    topicGroup->asyncFlushInterval = std::chrono::nanoseconds::zero();
+    if (maxFlushRate > 0.0)
+    {
+        topicGroup->asyncFlushInterval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::duration<double>(1.0 / maxFlushRate));
+    }
+    topicGroup->conflateWrites = true;
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::flush(const std::string& topicName)
+{
+    std::shared_ptr<AsyncWriterBase> asyncWriter;
+    {
+        decltype(m_sharedLock) lock(m_topicMutex);
+        auto iter = m_topics.find(topicName);
+        if (iter == m_topics.end() || iter->second == nullptr)
+        {
+            std::cerr << "Error flushing '"
+                << topicName
+                << "'. The topic has not been registered."
+                << std::endl;
+
+            return false;
+        }
+
+        asyncWriter = iter->second->asyncWriter;
+    }
+
+    if (!asyncWriter)
+    {
+        return true;
+    }
+
+    return asyncWriter->flush();
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::createReplayer(const std::string& topicName)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    // Make sure this topic has been registered
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() ||
+        iter->second == nullptr ||
+        iter->second->topic == nullptr)
+    {
+        std::cerr << "Error creating replayer for '"
+            << topicName
+            << "'. The topic has not been registered."
+            << std::endl;
+
+        return false;
+    }
+
+    std::shared_ptr<TopicGroup> topicGroup = iter->second;
+    if (topicGroup->replayer)
+    {
+        return true;
+    }
+
+    topicGroup->replayer = TheServiceParticipant->create_replayer(
+        m_domainParticipant,
+        topicGroup->topic,
+        topicGroup->pubQos,
+        topicGroup->dataWriterQos,
+        OpenDDS::DCPS::ReplayerListener_rch());
+
+    if (!topicGroup->replayer)
+    {
+        std::cerr << "Error creating replayer for '"
+            << topicName
+            << "'"
+            << std::endl;
+
+        return false;
+    }
+
+    return true;
+
+} // End DDSManager::createReplayer
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::writeSerialized(const std::string& topicName,
+    const ACE_Message_Block& payload)
+{
+    // Hold the lock while writing so the replayer can't be deleted under us
+    decltype(m_sharedLock) lock(m_topicMutex);
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() ||
+        iter->second == nullptr ||
+        !iter->second->replayer)
+    {
+        std::cerr << "Unable to find replayer for '"
+            << topicName
+            << "'"
+            << std::endl;
+        return false;
+    }
+
+    DDS::Time_t now = { 0, 0 };
+    m_domainParticipant->get_current_time(now);
+
+    // The sample takes its own reference to the payload
+    OpenDDS::DCPS::Message_Block_Ptr data(payload.duplicate());
+    const OpenDDS::DCPS::RawDataSample sample(OpenDDS::DCPS::SAMPLE_DATA,
+                                              now.sec,
+                                              now.nanosec,
+                                              OpenDDS::DCPS::GUID_UNKNOWN,
+                                              ACE_CDR_BYTE_ORDER,
+                                              data.get(),
+                                              QosDictionary::getEncodingKind());
+
+    const DDS::ReturnCode_t status = iter->second->replayer->write(sample);
+    if (status != DDS::RETCODE_OK)
+    {
+        checkStatus(status, "DDSManager::writeSerialized::write");
+        return false;
+    }
+
+    return true;
+
+} // End DDSManager::writeSerialized
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::writeSerialized(const std::string& topicName,
+    const char* data,
+    const size_t& size)
+{
+    if (!data || size == 0)
+    {
+        return false;
+    }
+
+    ACE_Message_Block payload(size);
+    if (payload.copy(data, size) != 0)
+    {
+        return false;
+    }
+
+    return writeSerialized(topicName, payload);
+}
+
+
+//------------------------------------------------------------------------------
+AsyncWriterStatistics DDSManager::getAsyncWriteStatistics(const std::string& topicName)
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() ||
+        iter->second == nullptr ||
+        !iter->second->asyncWriter)
+    {
+        return AsyncWriterStatistics();
+    }
+
+    return iter->second->asyncWriter->getStatistics();
+}
+
+
 //------------------------------------------------------------------------------
 bool DDSManager::addPartition(const std::string& topicName,
     const std::string& partitionName)
@@ -780,9 +1119,11 @@ bool DDSManager::createPublisher(const std::string& topicName)
 
             return false;
         }
+    }
 
-
-        // Create the data writer
+    // Create the data writer if one does not already exist. The publisher
+    // may have been created for a named writer.
+    if (!topicGroup->writer) {
         auto writerListener = std::make_unique<GenericWriterListener>();
         topicGroup->writer = topicGroup->publisher->create_datawriter(
             topicGroup->topic,
@@ -795,102 +1136,426 @@ bool DDSManager::createPublisher(const std::string& topicName)
             DDS::PUBLICATION_MATCHED_STATUS);
         writerListener->SetHandler(m_wlHandler);
 
-        if (!topicGroup->writer)
-        {
-            std::cerr << "Error creating data writer for '"
-                << topicName
-                << "'"
-                << std::endl;
+        if (!topicGroup->writer)
+        {
+            std::cerr << "Error creating data writer for '"
+                << topicName
+                << "'"
+                << std::endl;
+
+            return false;
+        }
+
+        topicGroup->m_writerListener = std::move(writerListener);
+        topicGroup->writerState = std::make_shared<TopicWriterState>();
+        topicGroup->writerState->instanceCache.enable(topicGroup->useInstanceCache);
+        topicGroup->writerState->changeFilter.enable(topicGroup->suppressUnchanged);
+    }
+
+    //std::cout << "Successfully created writer for topic '"
+    //    << topicName
+    //    << "' for handle: "
+    //    << topicGroup->topic->get_instance_handle()
+    //    << " with writer handle: "
+    //    << topicGroup->writer->get_instance_handle()
+    //    << std::endl;
+
+    return true;
+
+} // End DDSManager::createPublisher
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::createPublisher(const std::string& topicName,
+    const std::string& writerName,
+    const DDS::DataWriterQos& qos)
+{
+    if (writerName.empty())
+    {
+        std::cerr << "Error creating publisher for '"
+            << topicName
+            << "'. The writer name is empty."
+            << std::endl;
+
+        return false;
+    }
+
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    // Make sure this topic has been registered
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() ||
+        iter->second == nullptr ||
+        iter->second->topic == nullptr)
+    {
+        std::cerr << "Error creating publisher for '"
+            << topicName
+            << "'. The topic has not been registered."
+            << std::endl;
+
+        return false;
+    }
+
+    std::shared_ptr<TopicGroup> topicGroup = iter->second;
+
+    // If the named writer already exists, we're done
+    if (topicGroup->writers.find(writerName) != topicGroup->writers.end())
+    {
+        return true;
+    }
+
+    // Create the publisher if one does not already exist
+    if (!topicGroup->publisher) {
+        topicGroup->publisher = m_domainParticipant->create_publisher(
+            topicGroup->pubQos,
+            nullptr,
+            OpenDDS::DCPS::NO_STATUS_MASK);
+
+        if (!topicGroup->publisher)
+        {
+            std::cerr << "Error creating publisher for '"
+                << topicName
+                << "'"
+                << std::endl;
+
+            return false;
+        }
+    }
+
+    auto writerListener = std::make_unique<GenericWriterListener>();
+    DDS::DataWriter_var writer = topicGroup->publisher->create_datawriter(
+        topicGroup->topic,
+        qos,
+        writerListener.get(),
+        DDS::INCONSISTENT_TOPIC_STATUS |
+        DDS::OFFERED_INCOMPATIBLE_QOS_STATUS |
+        DDS::SAMPLE_LOST_STATUS |
+        DDS::SAMPLE_REJECTED_STATUS |
+        DDS::PUBLICATION_MATCHED_STATUS);
+    writerListener->SetHandler(m_wlHandler);
+
+    if (!writer)
+    {
+        std::cerr << "Error creating data writer '"
+            << writerName
+            << "' for '"
+            << topicName
+            << "'"
+            << std::endl;
+
+        return false;
+    }
+
+    auto state = std::make_shared<TopicWriterState>();
+    state->instanceCache.enable(topicGroup->useInstanceCache);
+    state->changeFilter.enable(topicGroup->suppressUnchanged);
+
+    topicGroup->writers.emplace(writerName, writer);
+    topicGroup->writerStates.emplace(writerName, state);
+    topicGroup->m_writerListeners.emplace(writerName, std::move(writerListener));
+
+    return true;
+
+} // End DDSManager::createPublisher
+
+
+//------------------------------------------------------------------------------
+uint64_t DDSManager::getSuppressedWriteCount(const std::string& topicName)
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        return 0;
+    }
+
+    uint64_t count = 0;
+    if (iter->second->writerState)
+    {
+        count += iter->second->writerState->changeFilter.suppressedCount();
+    }
+
+    for (const auto& state : iter->second->writerStates)
+    {
+        count += state.second->changeFilter.suppressedCount();
+    }
+
+    return count;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::createPublisherSubscriber(const std::string& topicName,
+    const std::string& readerName,
+    const std::string& filter,
+    const DDS::StringSeq &filterParams)
+{
+    // TODO: Remove this function (No longer used).
+    bool pass = false;
+
+    pass = createPublisher(topicName);
+    if (!pass)
+    {
+        return false;
+    }
+
+    pass = createSubscriber(topicName, readerName, filter, filterParams);
+    if (!pass)
+    {
+        return false;
+    }
+
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::readCallbacks(const std::string& topicName,
+    const std::string& readerName)
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
+    // Make sure the data reader name is valid
+    if (readerName.empty())
+    {
+        std::cerr << "Error reading callback data for '"
+            << topicName
+            << "'. The reader name must not be empty."
+            << std::endl;
+
+        return false;
+    }
+
+    auto iter = m_topics.find(topicName);
+
+    if (iter == m_topics.end())
+    {
+        return false;
+    }
+
+    std::shared_ptr<TopicGroup> topicGroup = iter->second;
+    if (!topicGroup)
+    {
+        return false;
+    }
+
+    auto emitterIter = topicGroup->emitters.find(readerName);
+    if (emitterIter == topicGroup->emitters.end() || !emitterIter->second)
+    {
+        return false;
+    }
+
+    // With a BLOCK queue limit readQueue may wait for callbacks to finish,
+    // and those callbacks may need the topic lock
+    std::shared_ptr<EmitterBase> emitter = emitterIter->second;
+    lock.unlock();
 
-            return false;
-        }
+    emitter->readQueue();
 
-        topicGroup->m_writerListener = std::move(writerListener);
+    return true;
+}
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::removeCallback(const std::string& topicName,
+    const std::string& readerName,
+    const EmitterBase::CallbackId& callbackId)
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end())
+    {
+        return false;
     }
 
-    //std::cout << "Successfully created writer for topic '"
-    //    << topicName
-    //    << "' for handle: "
-    //    << topicGroup->topic->get_instance_handle()
-    //    << " with writer handle: "
-    //    << topicGroup->writer->get_instance_handle()
-    //    << std::endl;
+    std::shared_ptr<TopicGroup> topicGroup = iter->second;
+    if (!topicGroup)
+    {
+        return false;
+    }
 
-    return true;
+    auto emitterIter = topicGroup->emitters.find(readerName);
+    if (emitterIter == topicGroup->emitters.end() || !emitterIter->second)
+    {
+        return false;
+    }
 
-} // End DDSManager::createPublisher
+    return emitterIter->second->removeCallback(callbackId);
+
+} // End DDSManager::removeCallback
 
 
 //------------------------------------------------------------------------------
-bool DDSManager::createPublisherSubscriber(const std::string& topicName,
+bool DDSManager::setInstanceOrdering(const std::string& topicName,
     const std::string& readerName,
-    const std::string& filter,
-    const DDS::StringSeq &filterParams)
+    const bool& ordered)
 {
-    // TODO: Remove this function (No longer used).
-    bool pass = false;
+    decltype(m_sharedLock) lock(m_topicMutex);
 
-    pass = createPublisher(topicName);
-    if (!pass)
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end())
     {
         return false;
     }
 
-    pass = createSubscriber(topicName, readerName, filter, filterParams);
-    if (!pass)
+    std::shared_ptr<TopicGroup> topicGroup = iter->second;
+    if (!topicGroup)
+    {
+        return false;
+    }
+
+    auto emitterIter = topicGroup->emitters.find(readerName);
+    if (emitterIter == topicGroup->emitters.end() || !emitterIter->second)
     {
+        std::cerr << "Unable to order callbacks of '"
+            << topicName
+            << "'. The data reader named '"
+            << readerName
+            << "' has no callbacks."
+            << std::endl;
+
         return false;
     }
 
+    emitterIter->second->setInstanceOrdering(ordered);
     return true;
-}
+
+} // End DDSManager::setInstanceOrdering
 
 
 //------------------------------------------------------------------------------
-bool DDSManager::readCallbacks(const std::string& topicName,
-    const std::string& readerName)
+bool DDSManager::setCallbackQueueLimit(const std::string& topicName,
+    const std::string& readerName,
+    const size_t& capacity,
+    const OverflowPolicy& policy)
 {
     decltype(m_sharedLock) lock(m_topicMutex);
 
-    // Make sure the data reader name is valid
-    if (readerName.empty())
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
     {
-        std::cerr << "Error reading callback data for '"
+        return false;
+    }
+
+    auto emitterIter = iter->second->emitters.find(readerName);
+    if (emitterIter == iter->second->emitters.end() || !emitterIter->second)
+    {
+        std::cerr << "Unable to bound the callback queue of '"
             << topicName
-            << "'. The reader name must not be empty."
+            << "'. The data reader named '"
+            << readerName
+            << "' has no callbacks."
             << std::endl;
 
         return false;
     }
 
+    emitterIter->second->setQueueLimit(capacity, policy);
+    return true;
+
+} // End DDSManager::setCallbackQueueLimit
+
+
+//------------------------------------------------------------------------------
+CallbackQueueStatistics DDSManager::getCallbackQueueStatistics(const std::string& topicName,
+    const std::string& readerName) const
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
     auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        return CallbackQueueStatistics();
+    }
 
-    if (iter == m_topics.end())
+    auto emitterIter = iter->second->emitters.find(readerName);
+    if (emitterIter == iter->second->emitters.end() || !emitterIter->second)
     {
-        return false;
+        return CallbackQueueStatistics();
     }
 
-    std::shared_ptr<TopicGroup> topicGroup = iter->second;
-    if (!topicGroup)
+    return emitterIter->second->getQueueStatistics();
+
+} // End DDSManager::getCallbackQueueStatistics
+
+
+//------------------------------------------------------------------------------
+bool DDSManager::setCallbackExecutor(std::shared_ptr<CallbackExecutor> executor,
+    const std::string& topicName)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+
+    if (topicName.empty() && !executor)
     {
         return false;
     }
 
-    if (topicGroup->emitters.find(readerName) == topicGroup->emitters.end())
+    // Emitters are bound to an executor when they are created
+    for (const auto& topic : m_topics)
     {
-        return false;
+        const bool affected = topicName.empty() ?
+            m_topicExecutors.find(topic.first) == m_topicExecutors.end() :
+            topic.first == topicName;
+
+        if (affected && topic.second && !topic.second->emitters.empty())
+        {
+            std::cerr << "Unable to set the callback executor of '"
+                << (topicName.empty() ? std::string("all topics") : topicName)
+                << "'. The data readers of '"
+                << topic.first
+                << "' already have callbacks."
+                << std::endl;
+
+            return false;
+        }
     }
 
-    auto& emitter = topicGroup->emitters[readerName];
-    if (!emitter)
+    if (!topicName.empty())
     {
-        return false;
+        if (executor)
+        {
+            m_topicExecutors[topicName] = executor;
+        }
+        else
+        {
+            m_topicExecutors.erase(topicName);
+        }
+        return true;
     }
 
-    emitter->readQueue();
+    std::shared_ptr<CallbackExecutor> previous = m_executor;
+    const bool shutdownPrevious = m_ownsExecutor && previous != executor;
+    m_ownsExecutor = m_ownsExecutor && previous == executor;
+    m_executor = executor;
+    lock.unlock();
+
+    // Runs the callbacks it still has queued, which may use the manager
+    if (shutdownPrevious)
+    {
+        previous->shutdown();
+    }
 
     return true;
-}
+
+} // End DDSManager::setCallbackExecutor
+
+
+//------------------------------------------------------------------------------
+std::shared_ptr<CallbackExecutor> DDSManager::getCallbackExecutor(const std::string& topicName) const
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
+    auto iter = m_topicExecutors.find(topicName);
+    if (iter != m_topicExecutors.end())
+    {
+        return iter->second;
+    }
+
+    return m_executor;
+
+} // End DDSManager::getCallbackExecutor
 
 
 //------------------------------------------------------------------------------
@@ -995,6 +1660,17 @@ bool DDSManager::replaceFilter(const std::string& topicName,
     DDS::TopicDescription_var topic = dataReader->get_topicdescription();
     DDS::ContentFilteredTopic_var topicDesc = DDS::ContentFilteredTopic::_narrow(topic);
 
+    // Drop the prepared query conditions of this reader
+    {
+        std::lock_guard<std::mutex> queryLock(topicGroup->queryCacheMutex);
+        auto cache = topicGroup->queryCaches.find(readerName);
+        if (cache != topicGroup->queryCaches.end())
+        {
+            cache->second->clear();
+            topicGroup->queryCaches.erase(cache);
+        }
+    }
+
     // We have to destroy the current data reader before building a new one
     // The first step is to delete the contained entities (deletes all the ReadConditions and QueryConditions)
     DDS::ReturnCode_t return_code = dataReader->delete_contained_entities();
@@ -1296,6 +1972,116 @@ bool DDSManager::setMaxDataRate(const std::string& topicName,
 } // End DDSManager::setMaxDataRate
 
 
+//------------------------------------------------------------------------------
+bool DDSManager::enableCallbackReactor(const size_t& threadCount)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+    if (m_reactor)
+    {
+        return false;
+    }
+
+    m_reactor = std::make_shared<WaitSetReactor>(threadCount);
+    return true;
+
+} // End DDSManager::enableCallbackReactor
+
+
+//------------------------------------------------------------------------------
+void DDSManager::setQueryCacheCapacity(const size_t& capacity)
+{
+    decltype(m_uniqueLock) lock(m_topicMutex);
+    m_queryCacheCapacity = capacity;
+
+    for (auto& topic : m_topics)
+    {
+        if (!topic.second)
+        {
+            continue;
+        }
+
+        std::lock_guard<std::mutex> queryLock(topic.second->queryCacheMutex);
+        for (auto& cache : topic.second->queryCaches)
+        {
+            cache.second->setCapacity(capacity);
+        }
+    }
+
+} // End DDSManager::setQueryCacheCapacity
+
+
+//------------------------------------------------------------------------------
+QueryCacheStatistics DDSManager::getQueryCacheStatistics(const std::string& topicName,
+    const std::string& readerName) const
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+
+    auto iter = m_topics.find(topicName);
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        return QueryCacheStatistics();
+    }
+
+    std::lock_guard<std::mutex> queryLock(iter->second->queryCacheMutex);
+    auto cache = iter->second->queryCaches.find(readerName);
+    if (cache == iter->second->queryCaches.end())
+    {
+        return QueryCacheStatistics();
+    }
+
+    return cache->second->getStatistics();
+
+} // End DDSManager::getQueryCacheStatistics
+
+
+//------------------------------------------------------------------------------
+std::shared_ptr<QueryConditionCache::Entry> DDSManager::getQueryCondition(
+    const std::string& topicName,
+    const std::string& readerName,
+    DDS::DataReader_ptr reader,
+    const std::string& filter,
+    const DDS::StringSeq& filterParams,
+    const DDS::SampleStateMask& sampleStates,
+    const DDS::ViewStateMask& viewStates)
+{
+    std::shared_ptr<QueryConditionCache> cache;
+    {
+        decltype(m_sharedLock) lock(m_topicMutex);
+
+        auto iter = m_topics.find(topicName);
+        if (iter == m_topics.end() || iter->second == nullptr)
+        {
+            return nullptr;
+        }
+
+        std::lock_guard<std::mutex> queryLock(iter->second->queryCacheMutex);
+        std::shared_ptr<QueryConditionCache>& readerCache = iter->second->queryCaches[readerName];
+        if (!readerCache)
+        {
+            readerCache = std::make_shared<QueryConditionCache>(m_queryCacheCapacity);
+        }
+
+        cache = readerCache;
+    }
+
+    std::shared_ptr<QueryConditionCache::Entry> query = cache->acquire(reader, filter, filterParams, sampleStates, viewStates);
+    if (!query)
+    {
+        std::cerr << "Unable to create the query condition '"
+            << filter
+            << "' for the topic '"
+            << topicName
+            << "' data reader named '"
+            << readerName
+            << "'"
+            << std::endl;
+    }
+
+    return query;
+
+} // End DDSManager::getQueryCondition
+
+
 //------------------------------------------------------------------------------
 DDS::DomainParticipant_var DDSManager::getDomainParticipant() const
 {
@@ -1406,6 +2192,28 @@ DDS::DataWriter_var DDSManager::getWriter(const std::string& topicName) const
 }
 
 
+//------------------------------------------------------------------------------
+DDS::DataWriter_var DDSManager::getWriter(const std::string& topicName,
+    const std::string& writerName) const
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+    auto iter = m_topics.find(topicName);
+
+    if (iter == m_topics.end() || iter->second == nullptr)
+    {
+        return nullptr;
+    }
+
+    auto writerIter = iter->second->writers.find(writerName);
+    if (writerIter == iter->second->writers.end())
+    {
+        return nullptr;
+    }
+
+    return writerIter->second;
+}
+
+
 //------------------------------------------------------------------------------
 DDS::Publisher_var DDSManager::getPublisher(const std::string& topicName) const
 {
@@ -1610,7 +2418,14 @@ DDSManager::TopicGroup::TopicGroup() :
     publisher(nullptr),
     subscriber(nullptr),
     writer(nullptr),
-    qosPreset(-1)
+    replayer(nullptr),
+    qosPreset(-1),
+    useInstanceCache(false),
+    suppressUnchanged(false),
+    asyncCapacity(1024),
+    asyncPolicy(OverflowPolicy::BLOCK),
+    asyncFlushInterval(std::chrono::nanoseconds::zero()),
+    conflateWrites(false)
 {
     topicQos = QosDictionary::Topic::latestReliableTransient();
     dataReaderQos = QosDictionary::DataReader::latestReliableTransient();
@@ -1623,6 +2438,10 @@ DDSManager::TopicGroup::TopicGroup() :
 DDSManager::TopicGroup::~TopicGroup()
 {
     int tempRet;
+
+    // A data reader with query conditions can't be deleted
+    queryCaches.clear();
+
     if (subscriber && !readers.empty())
     {
         for (auto iter = readers.begin(); iter != readers.end(); ++iter)
@@ -1640,6 +2459,47 @@ DDSManager::TopicGroup::~TopicGroup()
         readers.clear();
     }
 
+    // Write the samples still queued by writeAsync while the writer exists
+    if (asyncWriter)
+    {
+        asyncWriter->stop();
+        asyncWriter.reset();
+    }
+
+    // Wait for writes through TopicWriter handles before deleting the writer
+    if (writerState)
+    {
+        writerState->invalidate();
+    }
+
+    for (auto& state : writerStates)
+    {
+        state.second->invalidate();
+    }
+
+    if (replayer)
+    {
+        TheServiceParticipant->delete_replayer(replayer);
+        replayer = nullptr;
+    }
+
+    if (publisher && !writers.empty())
+    {
+        for (auto iter = writers.begin(); iter != writers.end(); ++iter)
+        {
+            tempRet = publisher->delete_datawriter(iter->second);
+            if (tempRet != DDS::RETCODE_OK) {
+                std::cerr << "Error in delete_datawriter: "
+                    << iter->first
+                    << " : "
+                    << getErrorName(tempRet)
+                    << std::endl;
+            }
+            iter->second = DDS::DataWriter::_nil();
+        }
+        writers.clear();
+    }
+
     if (publisher && writer)
     {
         tempRet = publisher->delete_datawriter(writer);
@@ -1675,6 +2535,12 @@ DDSManager::TopicGroup::~TopicGroup()
 
     //Moved this up because I'm not sure if it was causing delete_contentfilteredtopic and delete_topic
     //to fail sometimes. -MM
+    // Wake every emitter before joining any, so they stop in parallel
+    for (auto& emiter : emitters)
+    {
+        emiter.second->requestStop();
+    }
+
     for (auto& emiter : emitters)
     {
         emiter.second->stop();
@@ -1756,6 +2622,17 @@ void DDSManager::checkStatus(const DDS::ReturnCode_t& status, const char* info)
     }
 }
 
+//------------------------------------------------------------------------------
+size_t ddsTypeSlot(const std::type_index& type)
+{
+    static std::mutex slotMutex;
+    static std::unordered_map<std::type_index, size_t> slots;
+
+    std::lock_guard<std::mutex> lock(slotMutex);
+    // The next unused index is the number of types seen so far
+    return slots.emplace(type, slots.size()).first->second;
+}
+
 //------------------------------------------------------------------------------
 std::string ddsEnumToString(const CORBA::TypeCode* enumTypeCode,
     const unsigned int& enumValue)
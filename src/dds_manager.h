@@ -8,6 +8,7 @@
 #include <dds/DdsDcpsCoreC.h>
 #include <dds/DdsDcpsDomainC.h>
 #include <dds/DCPS/EventDispatcher.h>
+#include <dds/DCPS/Replayer.h>
 
 #ifdef WIN32
 #pragma warning(pop)
@@ -19,16 +20,37 @@
 #include <map>
 #include <memory>
 #include <shared_mutex>
+#include <typeindex>
 
 #include "dds_callback.h"
 #include "dds_listeners.h"
 #include "dds_logging.h"
 #include "dds_listeners.h"
+#include "dds_async_writer.h"
+#include "dds_last_value_cache.h"
+#include "dds_loaned_samples.h"
+#include "dds_query_cache.h"
+#include "dds_topic_writer.h"
 #include "participant_monitor.h"
 
 //User must supply this by compiling std_qos.idl.
 #include "std_qosC.h"
 
+/**
+ * @brief Which samples a read returns.
+ */
+enum class ReadMode
+{
+    /// Every ALIVE sample in the data reader, including samples read before.
+    ALL,
+    /// Only samples not returned by an earlier read (NOT_READ_SAMPLE_STATE).
+    NEW_SAMPLES,
+    /// Only samples of instances which are new to the reader (NEW_VIEW_STATE).
+    NEW_INSTANCES,
+    /// The latest unread sample of each instance with unread samples.
+    CHANGED_INSTANCES
+};
+
 /**
  * @brief Main interface into the DDS global data space.
  *
@@ -53,9 +75,16 @@
  *
  * - Enable the domain by calling the enableDomain method.
  *
- * - Read data samples with the takeSample and takeAllSamples methods.
+ * - Read data samples with the takeSample and takeAllSamples methods, into a
+ *   reused vector with the bounded takeInto and readInto methods, or
+ *   without copying them with the takeLoaned and readLoaned methods.
+ *   Threads which only need the latest sample of each instance can query
+ *   a cache from createLastValueCache instead.
  *
- * - Write new data samples with the writeSample method.
+ * - Write new data samples with the writeSample method, or through a
+ *   TopicWriter handle from getTopicWriter on high rate topics. Use
+ *   writeAsync to hand samples to a sender thread instead of waiting on
+ *   the data writer.
  */
 
 class DDSManager
@@ -189,6 +218,35 @@ public:
      */
     bool createPublisher(const std::string& topicName);
 
+    /**
+     * @brief Get the number of writes skipped by change suppression.
+     * @param[in] topicName The name of the topic.
+     * @return The number of suppressed writes of the default and named
+     *         writers of the topic, or zero if the topic has no writer.
+     */
+    uint64_t getSuppressedWriteCount(const std::string& topicName);
+
+    /**
+     * @brief Create a named data writer for a topic.
+     * @details Named writers are keyed by name on the topic publisher, the
+     *          same way data readers are. Each one is a separate data writer
+     *          with its own QoS, so bulk and urgent traffic can use different
+     *          history depths or transport priorities, and threads using
+     *          different writers do not contend on one writer's lock. The
+     *          instance cache and change suppression settings of the topic
+     *          apply to named writers too.
+     * @remarks Call this method after registerTopic. The publisher is created
+     *          if it does not already exist. The default writer from
+     *          createPublisher(topicName) is separate from named writers.
+     * @param[in] topicName The name of the topic.
+     * @param[in] writerName Unique data writer name per topic.
+     * @param[in] qos The QoS of the new data writer.
+     * @return True if the operation was successful; false otherwise.
+     */
+    bool createPublisher(const std::string& topicName,
+                         const std::string& writerName,
+                         const DDS::DataWriterQos& qos);
+
     /**
      * @brief Create a new topic publisher/subscriber.
      * @param[in] topicName The name of the topic.
@@ -207,22 +265,48 @@ public:
      * @param[in] topicName The name of the topic.
      * @param[in] readerName Unique data reader name.
      * @param[in] filter Take a sample matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was read; false otherwise.
+     */
+    template <typename TopicType>
+    bool takeSample(TopicType& sample,
+                    const std::string& topicName,
+                    const std::string& readerName,
+                    const std::string& filter = "",
+                    const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Read a single data sample and its SampleInfo for a given topic.
+     * @details The SampleInfo carries the source and reception timestamps,
+     *          the instance and publication handles and the generation counts.
+     * @param[out] sample Populate this object from the received sample.
+     * @param[out] info Populate this object from the sample's SampleInfo.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name.
+     * @param[in] filter Take a sample matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
      * @return True if new data was read; false otherwise.
      */
     template <typename TopicType>
     bool takeSample(TopicType& sample,
+                    DDS::SampleInfo& info,
                     const std::string& topicName,
                     const std::string& readerName,
-                    const std::string& filter = "");
+                    const std::string& filter = "",
+                    const DDS::StringSeq& filterParams = DDS::StringSeq());
 
     /**
      * @brief Read all data samples for a given topic.
-     * @param[out] samples Populate this vector from the received samples.
+     * @param[out] samples Replaced by the received samples. Left unchanged
+     *             when there is no data.
      * @param[in] topicName The name of the topic.
      * @param[in] readerName Unique data reader name per topic.
      * @param[in] filter Take all samples matching this optional filter.
      * @param[in] readOnly If true, the samples will not be removed from
      *            the data reader after reading.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @remarks Reading returns samples which were read before as well. Use
+     *          readInto with a ReadMode to read only new data.
      * @return True if new data was read; false otherwise.
      */
     template <typename TopicType>
@@ -230,7 +314,188 @@ public:
                         const std::string& topicName,
                         const std::string& readerName,
                         const std::string& filter = "",
-                        const bool& readOnly = false);
+                        const bool& readOnly = false,
+                        const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Read all data samples and their SampleInfo for a given topic.
+     * @param[out] samples Replaced by the received samples. Left unchanged
+     *             when there is no data.
+     * @param[out] infos Replaced by the SampleInfo of each sample, like samples.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] filter Take all samples matching this optional filter.
+     * @param[in] readOnly If true, the samples will not be removed from
+     *            the data reader after reading.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was read; false otherwise.
+     */
+    template <typename TopicType>
+    bool takeAllSamples(std::vector<TopicType>& samples,
+                        std::vector<DDS::SampleInfo>& infos,
+                        const std::string& topicName,
+                        const std::string& readerName,
+                        const std::string& filter = "",
+                        const bool& readOnly = false,
+                        const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Take data samples for a given topic without copying them.
+     * @details The samples stay in the data reader's loaned sequence and are
+     *          accessed by reference through the returned view. The loan is
+     *          returned when the view is destroyed.
+     * @remarks Keep the view short lived; the data reader holds the loaned
+     *          samples until they are returned.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] filter Take all samples matching this optional filter.
+     * @param[in] maxSamples The maximum number of samples to take.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return The loaned samples. Empty if there was no data or an error.
+     */
+    template <typename TopicType>
+    LoanedSamples<TopicType> takeLoaned(const std::string& topicName,
+                                        const std::string& readerName,
+                                        const std::string& filter = "",
+                                        const int& maxSamples = DDS::LENGTH_UNLIMITED,
+                                        const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Read data samples for a given topic without copying them.
+     * @details Same as takeLoaned, but the samples are left in the data reader.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] filter Read all samples matching this optional filter.
+     * @param[in] maxSamples The maximum number of samples to read.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return The loaned samples. Empty if there was no data or an error.
+     */
+    template <typename TopicType>
+    LoanedSamples<TopicType> readLoaned(const std::string& topicName,
+                                        const std::string& readerName,
+                                        const std::string& filter = "",
+                                        const int& maxSamples = DDS::LENGTH_UNLIMITED,
+                                        const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Take at most maxSamples data samples into a reused vector.
+     * @details The vector is cleared but keeps its capacity, so a caller
+     *          which passes the same vector every cycle stops allocating once
+     *          it has held maxSamples samples. With a positive bound, the data
+     *          reader copies the samples into a buffer owned by the calling
+     *          thread instead of loaning them, and they are moved into the
+     *          vector. Samples beyond the bound stay in the data reader for
+     *          the next call.
+     * @param[out] samples Replaced by the taken samples. Left unchanged
+     *             when there is no data.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] maxSamples The maximum number of samples to take.
+     *            DDS::LENGTH_UNLIMITED takes everything (copied from a loan).
+     * @param[in] filter Take samples matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was taken; false otherwise.
+     */
+    template <typename TopicType>
+    bool takeInto(std::vector<TopicType>& samples,
+                  const std::string& topicName,
+                  const std::string& readerName,
+                  const int& maxSamples,
+                  const std::string& filter = "",
+                  const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Same as takeInto, and also fill a reused vector of SampleInfo.
+     * @param[out] samples Replaced by the taken samples. Left unchanged
+     *             when there is no data.
+     * @param[out] infos Replaced by the SampleInfo of each sample, like samples.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] maxSamples The maximum number of samples to take.
+     * @param[in] filter Take samples matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was taken; false otherwise.
+     */
+    template <typename TopicType>
+    bool takeInto(std::vector<TopicType>& samples,
+                  std::vector<DDS::SampleInfo>& infos,
+                  const std::string& topicName,
+                  const std::string& readerName,
+                  const int& maxSamples,
+                  const std::string& filter = "",
+                  const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Read at most maxSamples data samples into a reused vector.
+     * @details Same as takeInto, but the samples are left in the data reader.
+     * @param[out] samples Replaced by the read samples. Left unchanged
+     *             when there is no data.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] maxSamples The maximum number of samples to read.
+     * @param[in] filter Read samples matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was read; false otherwise.
+     */
+    template <typename TopicType>
+    bool readInto(std::vector<TopicType>& samples,
+                  const std::string& topicName,
+                  const std::string& readerName,
+                  const int& maxSamples,
+                  const std::string& filter = "",
+                  const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Read only the samples selected by a read mode.
+     * @details The samples stay in the data reader, so its history can still
+     *          be inspected later, but ReadMode::NEW_SAMPLES and
+     *          ReadMode::CHANGED_INSTANCES skip samples returned by earlier
+     *          reads. The work per call then depends on the new data rather
+     *          than on the whole history.
+     * @param[out] samples Replaced by the read samples. Left unchanged
+     *             when there is no data.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] maxSamples The maximum number of samples to read, or
+     *            DDS::LENGTH_UNLIMITED.
+     * @param[in] mode Which samples to read.
+     * @param[in] filter Read samples matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was read; false otherwise.
+     */
+    template <typename TopicType>
+    bool readInto(std::vector<TopicType>& samples,
+                  const std::string& topicName,
+                  const std::string& readerName,
+                  const int& maxSamples,
+                  const ReadMode& mode,
+                  const std::string& filter = "",
+                  const DDS::StringSeq& filterParams = DDS::StringSeq());
+
+    /**
+     * @brief Same as readInto with a read mode, and also fill a reused
+     *        vector of SampleInfo.
+     * @param[out] samples Replaced by the read samples. Left unchanged
+     *             when there is no data.
+     * @param[out] infos Replaced by the SampleInfo of each sample, like samples.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] maxSamples The maximum number of samples to read, or
+     *            DDS::LENGTH_UNLIMITED.
+     * @param[in] mode Which samples to read.
+     * @param[in] filter Read samples matching this optional filter.
+     * @param[in] filterParams Parameters for the filter ("%0", "%1", ...).
+     * @return True if new data was read; false otherwise.
+     */
+    template <typename TopicType>
+    bool readInto(std::vector<TopicType>& samples,
+                  std::vector<DDS::SampleInfo>& infos,
+                  const std::string& topicName,
+                  const std::string& readerName,
+                  const int& maxSamples,
+                  const ReadMode& mode,
+                  const std::string& filter = "",
+                  const DDS::StringSeq& filterParams = DDS::StringSeq());
 
     /**
      * @brief Write a data sample for a given topic.
@@ -252,6 +517,274 @@ public:
     bool disposeSample(const TopicType& topicInstance,
         const std::string& topicName);
 
+    /**
+     * @brief Write a data sample with a named writer.
+     * @param[in] topicInstance Write this topic instance as a data sample.
+     * @param[in] topicName The name of the topic.
+     * @param[in] writerName The name given to createPublisher.
+     * @return True if new data was written; false otherwise.
+     */
+    template <typename TopicType>
+    bool writeSample(const TopicType& topicInstance,
+                     const std::string& topicName,
+                     const std::string& writerName);
+
+    /**
+     * @brief Dispose of a data sample with a named writer.
+     * @param[in] topicInstance Dispose of this topic instance as a data sample.
+     * @param[in] topicName The name of the topic.
+     * @param[in] writerName The name given to createPublisher.
+     * @return True if new data was disposed; false otherwise.
+     */
+    template <typename TopicType>
+    bool disposeSample(const TopicType& topicInstance,
+                       const std::string& topicName,
+                       const std::string& writerName);
+
+    /**
+     * @brief Enable or disable the instance handle cache for a given topic.
+     * @details When enabled, each key is registered with the data writer the
+     *          first time it is written and later writes and disposes pass
+     *          the cached instance handle. This saves OpenDDS from marshaling
+     *          and looking up the key of every sample on keyed topics with
+     *          many instances. Disposing of a sample evicts its key.
+     * @remarks This may be called before or after createPublisher.
+     * @param[in] topicName The name of the topic.
+     * @param[in] enable True to enable the cache; false to disable and clear it.
+     * @return True if the operation was successful; false otherwise.
+     */
+    bool enableInstanceCache(const std::string& topicName,
+                             const bool& enable = true);
+
+    /**
+     * @brief Enable or disable change suppression for a given topic.
+     * @details When enabled, writes of a sample identical to the last sample
+     *          written for the same instance are skipped. Samples are
+     *          compared by a hash of their serialized form. Applies to the
+     *          default and named writers of the topic.
+     * @remarks This may be called before or after createPublisher. See
+     *          getSuppressedWriteCount.
+     * @param[in] topicName The name of the topic.
+     * @param[in] enable True to skip unchanged samples; false to write every
+     *            sample and clear the remembered samples.
+     * @return True if the operation was successful; false otherwise.
+     */
+    bool enableChangeSuppression(const std::string& topicName,
+                                 const bool& enable = true);
+
+    /**
+     * @brief Write a batch of data samples for a given topic.
+     * @details The data writer is looked up once for the whole batch. When
+     *          coherent is true, the batch is wrapped in a coherent set so
+     *          readers see all of the samples or none of them.
+     * @remarks Coherent sets require the publisher and subscriber QoS to
+     *          have presentation.coherent_access enabled (see
+     *          setPublisherQos and setSubscriberQos). If the coherent set
+     *          cannot be started, nothing is written and false is returned.
+     * @param[in] samples Pointer to the first data sample to write.
+     * @param[in] count The number of data samples to write.
+     * @param[in] topicName The name of the topic.
+     * @param[in] coherent If true, write the batch as a coherent set.
+     * @return True if every sample was written; false otherwise.
+     */
+    template <typename TopicType>
+    bool writeSamples(const TopicType* samples,
+                      const size_t& count,
+                      const std::string& topicName,
+                      const bool& coherent = false);
+
+    /**
+     * @brief Write a batch of data samples for a given topic.
+     * @param[in] samples Write these topic instances as data samples.
+     * @param[in] topicName The name of the topic.
+     * @param[in] coherent If true, write the batch as a coherent set.
+     * @return True if every sample was written; false otherwise.
+     */
+    template <typename TopicType>
+    bool writeSamples(const std::vector<TopicType>& samples,
+                      const std::string& topicName,
+                      const bool& coherent = false);
+
+    /**
+     * @brief Dispose of a batch of data samples for a given topic.
+     * @details See writeSamples for the coherent set requirements.
+     * @param[in] samples Pointer to the first data sample to dispose.
+     * @param[in] count The number of data samples to dispose.
+     * @param[in] topicName The name of the topic.
+     * @param[in] coherent If true, dispose of the batch as a coherent set.
+     * @return True if every sample was disposed; false otherwise.
+     */
+    template <typename TopicType>
+    bool disposeSamples(const TopicType* samples,
+                        const size_t& count,
+                        const std::string& topicName,
+                        const bool& coherent = false);
+
+    /**
+     * @brief Dispose of a batch of data samples for a given topic.
+     * @param[in] samples Dispose of these topic instances as data samples.
+     * @param[in] topicName The name of the topic.
+     * @param[in] coherent If true, dispose of the batch as a coherent set.
+     * @return True if every sample was disposed; false otherwise.
+     */
+    template <typename TopicType>
+    bool disposeSamples(const std::vector<TopicType>& samples,
+                        const std::string& topicName,
+                        const bool& coherent = false);
+
+    /**
+     * @brief Get a pre-resolved writer handle for a given topic.
+     * @details The handle caches the narrowed data writer, so writing through
+     *          it skips the topic lookup and narrow done by writeSample. The
+     *          handle is invalidated when the topic is unregistered.
+     * @remarks Call this method after createPublisher.
+     * @param[in] topicName The name of the topic.
+     * @return A valid handle if the topic writer was found; otherwise an
+     *         invalid handle.
+     */
+    template <typename TopicType>
+    TopicWriter<TopicType> getTopicWriter(const std::string& topicName);
+
+    /**
+     * @brief Get a pre-resolved handle for a named writer of a topic.
+     * @param[in] topicName The name of the topic.
+     * @param[in] writerName The name given to createPublisher. If empty,
+     *            the default writer of the topic is used.
+     * @return A valid handle if the topic writer was found; otherwise an
+     *         invalid handle.
+     */
+    template <typename TopicType>
+    TopicWriter<TopicType> getTopicWriter(const std::string& topicName,
+                                          const std::string& writerName);
+
+    /**
+     * @brief Configure the asynchronous publish queue for a given topic.
+     * @details Takes effect when the queue is created by the first call to
+     *          writeAsync. The default is a queue of 1024 samples with
+     *          OverflowPolicy::BLOCK.
+     * @remarks This may be called before or after createPublisher, but not
+     *          after the first call to writeAsync.
+     * @param[in] topicName The name of the topic.
+     * @param[in] capacity Maximum number of queued samples, rounded up to a
+     *            power of two. For OverflowPolicy::CONFLATE this is the
+     *            maximum number of instance keys waiting to be written.
+     * @param[in] policy What to do with a new sample when the queue is full.
+     * @return True if the operation was successful; false otherwise.
+     */
+    bool setAsyncWriteOptions(const std::string& topicName,
+                              const size_t& capacity,
+                              const OverflowPolicy& policy);
+
+    /**
+     * @brief Queue a data sample to be written by a sender thread.
+     * @details The caller does not wait for the data writer, which can block
+     *          for up to max_blocking_time on reliable topics. The first call
+     *          for a topic creates its queue and sender thread. Samples still
+     *          queued when the topic is unregistered are written first.
+     * @remarks Call this method after createPublisher. Samples written with
+     *          writeAsync may be reordered with samples written directly.
+     * @param[in] sample Write this topic instance as a data sample.
+     * @param[in] topicName The name of the topic.
+     * @return True if the sample was queued; false if it was dropped or the
+     *         topic has no writer.
+     */
+    template <typename TopicType>
+    bool writeAsync(const TopicType& sample, const std::string& topicName);
+
+    /**
+     * @brief Get the counters of the asynchronous publish queue for a topic.
+     * @param[in] topicName The name of the topic.
+     * @return The queue counters. All zero if writeAsync was never called.
+     */
+    AsyncWriterStatistics getAsyncWriteStatistics(const std::string& topicName);
+
+    /**
+     * @brief Conflate the samples written to a given topic.
+     * @details Once enabled, writeSample keeps only the latest sample for each
+     *          instance in a small table, and a sender thread writes the table
+     *          at no more than maxFlushRate times per second. Intermediate
+     *          samples of a fast changing instance are never sent. This uses
+     *          the asynchronous publish queue with OverflowPolicy::CONFLATE;
+     *          the counters are available from getAsyncWriteStatistics.
+     *          disposeSample, writeSamples and disposeSamples flush the table
+     *          before they write so samples are not reordered.
+     * @remarks Only topics whose writer keeps the last sample per instance
+     *          (such as STD_QOS::QosType::LATEST_RELIABLE and
+     *          LATEST_RELIABLE_TRANSIENT) can be conflated. Call this method
+     *          before the first write to the topic.
+     * @param[in] topicName The name of the topic.
+     * @param[in] maxFlushRate Maximum flushes per second. Zero writes the
+     *            latest samples as soon as the sender thread is free.
+     * @param[in] maxInstances Maximum number of instances waiting to be
+     *            written. Samples of new instances beyond this are dropped.
+     * @return True if the operation was successful; false otherwise.
+     */
+    bool enableConflation(const std::string& topicName,
+                          const double& maxFlushRate = 0.0,
+                          const size_t& maxInstances = 1024);
+
+    /**
+     * @brief Write the samples queued by writeAsync or conflation right away.
+     * @param[in] topicName The name of the topic.
+     * @return True if the queue was flushed or the topic has no queue;
+     *         false otherwise.
+     */
+    bool flush(const std::string& topicName);
+
+    /**
+     * @brief Create a replayer for publishing pre-serialized samples.
+     * @details A replayer is a data writer that publishes CDR payloads as
+     *          they are, so relays and bridges can forward samples without
+     *          deserializing and serializing them again. It is created with
+     *          the publisher and data writer QoS of the topic.
+     * @remarks Call this method after registerTopic. The replayer is separate
+     *          from the data writer made by createPublisher.
+     * @param[in] topicName The name of the topic.
+     * @return True if the operation was successful; false otherwise.
+     */
+    bool createReplayer(const std::string& topicName);
+
+    /**
+     * @brief Publish a pre-serialized data sample for a given topic.
+     * @details The payload is an encapsulation header followed by the sample
+     *          in native byte order, encoded with the
+     *          QosDictionary::getEncodingKind() representation the topic was
+     *          registered with. ddsSerializeSample produces this layout. The
+     *          replayer keeps a reference to the payload instead of copying
+     *          it, so the block must not be modified after the call.
+     * @remarks Call createReplayer first.
+     * @param[in] topicName The name of the topic.
+     * @param[in] payload The serialized data sample.
+     * @return True if the sample was written; false otherwise.
+     */
+    bool writeSerialized(const std::string& topicName,
+                         const ACE_Message_Block& payload);
+
+    /**
+     * @brief Publish a pre-serialized data sample for a given topic.
+     * @details Same as above, but the bytes are copied into a new message block.
+     * @param[in] topicName The name of the topic.
+     * @param[in] data Pointer to the first byte of the serialized sample.
+     * @param[in] size The number of bytes in the serialized sample.
+     * @return True if the sample was written; false otherwise.
+     */
+    bool writeSerialized(const std::string& topicName,
+                         const char* data,
+                         const size_t& size);
+
+    /**
+     * @brief Serialize a data sample once and publish it to several topics.
+     * @details Each destination is a manager (one per domain) and a topic
+     *          name with a replayer created by createReplayer. The same
+     *          payload is shared by every write.
+     * @param[in] sample The data sample to publish.
+     * @param[in] destinations The managers and topic names to publish to.
+     * @return The number of destinations the sample was written to.
+     */
+    template <typename TopicType>
+    static size_t writeSerializedFanout(const TopicType& sample,
+        const std::vector<std::pair<DDSManager*, std::string>>& destinations);
+
     /**
      * @brief Add a data callback to a specified data reader.
      * @param[in] topicName The name of the topic.
@@ -260,6 +793,8 @@ public:
      * @param[in] queueMessages If true, callback methods will only be invoked
      *            when the readCallbacks function is called. When false,
      *            callbacks are invoked immediately after data is received.
+     * @param[out] callbackId Optionally set to the id of the callback, for
+     *             removeCallback.
      * @return True if the operation was successful; false otherwise.
      */
     template <typename TopicType>
@@ -267,7 +802,219 @@ public:
                      const std::string& readerName,
                      std::function<void(const TopicType&)> func,
                      const bool& queueMessages = false,
-                     const bool& asyncHandling = false);
+                     const bool& asyncHandling = false,
+                     EmitterBase::CallbackId* callbackId = nullptr);
+
+    /**
+     * @brief Add a data callback which also receives each sample's SampleInfo.
+     * @details Same as addCallback. Synchronous callbacks get the SampleInfo
+     *          by reference from the taken sequence, so it is not copied.
+     * @remarks This is not an addCallback overload, since std::bind results
+     *          would convert to either function type.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] func std::function which will be callback.
+     * @param[in] queueMessages If true, callback methods will only be invoked
+     *            when the readCallbacks function is called. When false,
+     *            callbacks are invoked immediately after data is received.
+     * @param[in] asyncHandling If true, callbacks run on the thread pool.
+     * @param[out] callbackId Optionally set to the id of the callback, for
+     *             removeCallback.
+     * @return True if the operation was successful; false otherwise.
+     */
+    template <typename TopicType>
+    bool addCallbackWithInfo(const std::string& topicName,
+                             const std::string& readerName,
+                             std::function<void(const TopicType&, const DDS::SampleInfo&)> func,
+                             const bool& queueMessages = false,
+                             const bool& asyncHandling = false,
+                             EmitterBase::CallbackId* callbackId = nullptr);
+
+    /**
+     * @brief Add a callback which receives every sample of a take at once.
+     * @details Called once per take with a view of all the samples taken and
+     *          their SampleInfo, instead of once per sample. Synchronous
+     *          callbacks view the loaned samples without copying them.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] func std::function which will be callback.
+     * @param[in] queueMessages If true, callback methods will only be invoked
+     *            when the readCallbacks function is called. When false,
+     *            callbacks are invoked immediately after data is received.
+     * @param[in] asyncHandling If true, callbacks run on the thread pool.
+     * @param[out] callbackId Optionally set to the id of the callback, for
+     *             removeCallback.
+     * @return True if the operation was successful; false otherwise.
+     */
+    template <typename TopicType>
+    bool addBatchCallback(const std::string& topicName,
+                          const std::string& readerName,
+                          std::function<void(const SampleBatch<TopicType>&)> func,
+                          const bool& queueMessages = false,
+                          const bool& asyncHandling = false,
+                          EmitterBase::CallbackId* callbackId = nullptr);
+
+    /**
+     * @brief Add callbacks for instances which are disposed or have no writers.
+     * @details Callbacks run from the same emitter as addCallback. Once added,
+     *          the emitter also takes the samples of instances which are not
+     *          alive, so the reader no longer keeps those samples.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] onDisposed Called with the key of a disposed instance (only
+     *            the key fields are set). May be empty.
+     * @param[in] onNoWriters Called with the key of an instance whose
+     *            writers are all gone. May be empty.
+     * @param[in] purgeDelay If not negative, the reader's autopurge delays
+     *            for disposed and no writers instances in millisecs. Keeps
+     *            reader memory bounded on topics with many short lived keys.
+     * @param[in] queueMessages If true, callback methods will only be invoked
+     *            when the readCallbacks function is called.
+     * @param[in] asyncHandling If true, callbacks run on the thread pool.
+     * @param[out] callbackId Optionally set to the id of the callback, for
+     *             removeCallback.
+     * @return True if the operation was successful; false otherwise.
+     */
+    template <typename TopicType>
+    bool addLifecycleCallback(const std::string& topicName,
+                              const std::string& readerName,
+                              std::function<void(const TopicType&)> onDisposed,
+                              std::function<void(const TopicType&)> onNoWriters,
+                              const int& purgeDelay = -1,
+                              const bool& queueMessages = false,
+                              const bool& asyncHandling = false,
+                              EmitterBase::CallbackId* callbackId = nullptr);
+
+    /**
+     * @brief Remove a callback added to a data reader.
+     * @details A callback already running, or queued in async mode, still
+     *          finishes. The data reader keeps its emitter.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] callbackId The id set when the callback was added.
+     * @return True if the callback was found and removed; false otherwise.
+     */
+    bool removeCallback(const std::string& topicName,
+                        const std::string& readerName,
+                        const EmitterBase::CallbackId& callbackId);
+
+    /**
+     * @brief Keep the latest sample of every instance received by a reader.
+     * @details The reader thread of the data reader stores each sample in
+     *          the returned cache, which any thread can query by instance key
+     *          without blocking the reader thread. Instances which are
+     *          disposed or lose all their writers are removed from the cache.
+     * @remarks The data reader's samples are taken by the reader thread, so
+     *          the data reader must be dedicated to the cache: it fails for a
+     *          data reader which already has callbacks, and callbacks should
+     *          not be added to the data reader afterwards. The cache lives as
+     *          long as the data reader or the returned pointer.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @return The cache, or nullptr if the data reader does not exist or
+     *         already has callbacks.
+     */
+    template <typename TopicType>
+    std::shared_ptr<const LastValueCache<TopicType>> createLastValueCache(const std::string& topicName,
+                                                                        const std::string& readerName);
+
+    /**
+     * @brief Dispatch callbacks from a few shared threads.
+     * @details By default every data reader with callbacks gets its own
+     *          thread and WaitSet. Once this is called, callbacks added later
+     *          are dispatched by a fixed number of threads which share the
+     *          waiting for all those readers, so the thread count stays the
+     *          same as subscriptions are added.
+     * @remarks Call this method before addCallback. Readers which already
+     *          have callbacks keep their own threads. A slow callback delays
+     *          the other readers served by its thread, and so does a reader
+     *          whose full BLOCK callback queue (see setCallbackQueueLimit)
+     *          makes the thread wait.
+     * @param[in] threadCount The number of dispatch threads.
+     * @return True if the threads were started; false if they already were.
+     */
+    bool enableCallbackReactor(const size_t& threadCount = 1);
+
+    /**
+     * @brief Run the asynchronous callbacks of each instance in order.
+     * @details Samples of the same instance are handled one at a time in the
+     *          order they were received, so async handling can be used for
+     *          state topics. Different instances are still handled in
+     *          parallel on the thread pool.
+     * @remarks Call this method after adding a callback with asyncHandling
+     *          set. It has no effect on synchronous callbacks.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] ordered True to order callbacks per instance.
+     * @return True if the reader has callbacks; false otherwise.
+     */
+    bool setInstanceOrdering(const std::string& topicName,
+                             const std::string& readerName,
+                             const bool& ordered = true);
+
+    /**
+     * @brief Bound the asynchronous callbacks of a reader waiting to run.
+     * @details Without a bound, a consumer which falls behind (such as
+     *          during a replay burst) makes the callback queue grow until
+     *          memory runs out. See EmitterBase::setQueueLimit for the
+     *          policies.
+     * @remarks Call this method after adding a callback with asyncHandling
+     *          set. BLOCK pushes back on DDS: samples stay in the reader's
+     *          history until the queue has room, and the thread which reads
+     *          them waits with the current take on loan. When queueMessages
+     *          is set, that is the thread calling readCallbacks; if it is one
+     *          of the reader's own callbacks, callbacks which do not fit are
+     *          dropped rather than waiting for it to finish. With the callback
+     *          reactor (see enableCallbackReactor), the waiting thread is the
+     *          reactor thread, so every other reader it serves stalls too.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @param[in] capacity The most callbacks waiting to run. Zero removes
+     *            the bound.
+     * @param[in] policy What to do with a callback when the queue is full.
+     * @return True if the reader has callbacks; false otherwise.
+     */
+    bool setCallbackQueueLimit(const std::string& topicName,
+                               const std::string& readerName,
+                               const size_t& capacity,
+                               const OverflowPolicy& policy = OverflowPolicy::BLOCK);
+
+    /**
+     * @brief Get the counters of the bounded callback queue of a reader.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @return The queue counters. All zero if the queue is not bounded.
+     */
+    CallbackQueueStatistics getCallbackQueueStatistics(const std::string& topicName,
+                                                       const std::string& readerName) const;
+
+    /**
+     * @brief Run the asynchronous callbacks of a topic, or of all topics,
+     *        with an executor.
+     * @details The executor of a topic isolates its callbacks from the other
+     *          topics, so a slow consumer does not delay them. The default
+     *          executor runs on the thread pool created by the constructor.
+     * @remarks Emitters keep the executor they were created with, so this
+     *          fails once a data reader of the topic has callbacks (or, for
+     *          the default executor, a data reader of any topic without its
+     *          own executor). The manager keeps the executor until it is
+     *          replaced, and only shuts down the executor it created.
+     * @param[in] executor The executor, such as a WorkStealingExecutor. When
+     *            nullptr, the topic goes back to the default executor.
+     * @param[in] topicName The topic. When empty, replaces the default
+     *            executor (nullptr then fails).
+     * @return True if the executor was set; false otherwise.
+     */
+    bool setCallbackExecutor(std::shared_ptr<CallbackExecutor> executor,
+                             const std::string& topicName = "");
+
+    /**
+     * @brief Get the executor which runs the asynchronous callbacks of a topic.
+     * @remarks Use getStatistics on the result to monitor its queue.
+     * @param[in] topicName The topic. When empty, the default executor.
+     * @return The executor of the topic, or the default executor.
+     */
+    std::shared_ptr<CallbackExecutor> getCallbackExecutor(const std::string& topicName = "") const;
 
     /**
      * @brief Invoke callback methods for each message in the middleware.
@@ -325,6 +1072,28 @@ public:
                         const std::string& readerName,
                         const int& rate);
 
+    /**
+     * @brief Set how many prepared query conditions each data reader keeps.
+     * @details The filter parameter of takeSample, takeAllSamples, takeLoaned
+     *          and readLoaned is prepared as a query condition the first time
+     *          it is used and kept for later takes. Filters with "%0" style
+     *          parameters are prepared once and the parameters are rebound on
+     *          each take. When a reader has more filters than this, the least
+     *          recently used condition is deleted.
+     * @param[in] capacity Maximum query conditions per data reader. The
+     *            default is QueryConditionCache::DefaultCapacity.
+     */
+    void setQueryCacheCapacity(const size_t& capacity);
+
+    /**
+     * @brief Get the counters of the prepared query conditions of a reader.
+     * @param[in] topicName The name of the topic.
+     * @param[in] readerName Unique data reader name per topic.
+     * @return The cache counters. All zero if the reader never used a filter.
+     */
+    QueryCacheStatistics getQueryCacheStatistics(const std::string& topicName,
+                                                 const std::string& readerName) const;
+
     /**
      * @brief Return the domain participant object.
      * @return The domain participant object if it was found; otherwise nullptr.
@@ -369,6 +1138,15 @@ public:
      */
     DDS::DataWriter_var getWriter(const std::string& topicName) const;
 
+    /**
+     * @brief Get a named data writer associated with a topic.
+     * @param[in] topicName The name of the topic.
+     * @param[in] writerName The name given to createPublisher.
+     * @return The data writer object if it was found; otherwise nullptr.
+     */
+    DDS::DataWriter_var getWriter(const std::string& topicName,
+                                  const std::string& writerName) const;
+
     /**
      * @brief Get the data publisher associated with a topic.
      * @param[in] topicName The name of the topic.
@@ -526,9 +1304,36 @@ private:
         std::unique_ptr<GenericTopicListener> m_listener;
         std::unique_ptr<GenericWriterListener> m_writerListener;
 
+        /// Lifetime of the writer shared with TopicWriter handles.
+        std::shared_ptr<TopicWriterState> writerState;
+
+        /// Publishes pre-serialized samples (see createReplayer).
+        OpenDDS::DCPS::Replayer_ptr replayer;
+
         /// The QoS type for this topic (STD_DOC::QosType).
         int qosPreset;
 
+        /// Enable the instance handle cache when the writer is created.
+        bool useInstanceCache;
+
+        /// Skip writes of samples which have not changed (see createPublisher).
+        bool suppressUnchanged;
+
+        /// Asynchronous publish queue, created by the first writeAsync call.
+        std::shared_ptr<AsyncWriterBase> asyncWriter;
+
+        /// Capacity of the asynchronous publish queue.
+        size_t asyncCapacity;
+
+        /// Overflow policy of the asynchronous publish queue.
+        OverflowPolicy asyncPolicy;
+
+        /// Minimum time between drains of the asynchronous publish queue.
+        std::chrono::nanoseconds asyncFlushInterval;
+
+        /// Route writeSample through the conflating publish queue.
+        bool conflateWrites;
+
         /**
         * @brief Stores the filtered topic objects.
         * @details The key is the data reader name and the value is the topic.
@@ -541,6 +1346,30 @@ private:
         */
         std::map<const std::string, DDS::DataReader_var> readers;
 
+        /**
+        * @brief Stores the prepared query conditions of each data reader.
+        * @details The key is the data reader name. Guarded by queryCacheMutex
+        *          so takes holding the shared topic lock can add caches.
+        */
+        std::map<const std::string, std::shared_ptr<QueryConditionCache>> queryCaches;
+        std::mutex queryCacheMutex;
+
+        /**
+        * @brief Stores the named data writer objects.
+        * @details The key is the data writer name and the value is the writer.
+        *          The default writer is not stored here.
+        */
+        std::map<const std::string, DDS::DataWriter_var> writers;
+
+        /**
+        * @brief Lifetime of each named writer shared with TopicWriter handles.
+        * @details The key is the data writer name.
+        */
+        std::map<const std::string, std::shared_ptr<TopicWriterState>> writerStates;
+
+        /// Listeners of the named data writers, keyed by writer name.
+        std::map<const std::string, std::unique_ptr<GenericWriterListener>> m_writerListeners;
+
         /**
         * @brief Stores the callback emitter objects.
         * @details The key is the data reader name and the value is the emitter.
@@ -548,7 +1377,136 @@ private:
         std::map<const std::string, std::shared_ptr<EmitterBase>> emitters;
     };
 
-    OpenDDS::DCPS::RcHandle<OpenDDS::DCPS::EventDispatcher> m_dispatcher;
+    /**
+    * @brief Find the data writer for a topic and narrow it to the topic type.
+    * @param[in] topicName The name of the topic.
+    * @param[out] state Optionally receives the lifetime state of the writer.
+    * @param[out] conflate Optionally receives whether writes to the topic are
+    *             conflated. If true, the writer is not narrowed and nil is
+    *             returned.
+    * @param[in] writerName The name given to createPublisher. If empty, the
+    *            default writer of the topic is used.
+    * @return The typed data writer if it was found; otherwise nil.
+    */
+    template <typename TopicType>
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type
+    getTypedWriter(const std::string& topicName,
+                   std::shared_ptr<TopicWriterState>* state = nullptr,
+                   bool* conflate = nullptr,
+                   const std::string& writerName = "") const;
+
+    /**
+    * @brief Get the prepared query condition for a filter of a data reader.
+    * @param[in] topicName The name of the topic.
+    * @param[in] readerName Unique data reader name per topic.
+    * @param[in] reader The data reader.
+    * @param[in] filter The query expression.
+    * @param[in] filterParams The query parameters used if it is created.
+    * @param[in] sampleStates The sample states the condition selects.
+    * @param[in] viewStates The view states the condition selects.
+    * @return The cached condition, or nullptr if it could not be created.
+    */
+    std::shared_ptr<QueryConditionCache::Entry> getQueryCondition(const std::string& topicName,
+                                                                  const std::string& readerName,
+                                                                  DDS::DataReader_ptr reader,
+                                                                  const std::string& filter,
+                                                                  const DDS::StringSeq& filterParams,
+                                                                  const DDS::SampleStateMask& sampleStates = DDS::ANY_SAMPLE_STATE,
+                                                                  const DDS::ViewStateMask& viewStates = DDS::ANY_VIEW_STATE);
+
+    /**
+    * @brief Take or read samples on loan for takeLoaned and readLoaned.
+    * @param[in] info Name of the calling method for error messages.
+    */
+    template <typename TopicType>
+    LoanedSamples<TopicType> loanSamples(const std::string& topicName,
+                                         const std::string& readerName,
+                                         const std::string& filter,
+                                         const DDS::StringSeq& filterParams,
+                                         const int& maxSamples,
+                                         const bool& readOnly,
+                                         const char* info);
+
+    /**
+    * @brief Find or create the emitter of a data reader and add a callback.
+    * @param[in] registerCallback Called with the Emitter<TopicType> to add
+    *            the callback to it. Returns the id of the callback.
+    * @param[in] exclusive If true, fail instead of adding to an emitter the
+    *            data reader already has.
+    * @param[out] callbackId Optionally set to the id of the callback.
+    */
+    template <typename TopicType, typename Registration>
+    bool addEmitterCallback(const std::string& topicName,
+                            const std::string& readerName,
+                            Registration registerCallback,
+                            const bool& queueMessages,
+                            const bool& asyncHandling,
+                            const bool& exclusive = false,
+                            EmitterBase::CallbackId* callbackId = nullptr);
+
+    /**
+    * @brief Take or read samples into a vector for takeInto and readInto.
+    * @details samples and infos are only cleared once a take succeeds.
+    * @param[out] infos Optionally filled with the SampleInfo of each sample.
+    * @param[in] info Name of the calling method for error messages.
+    */
+    template <typename TopicType>
+    bool copySamples(std::vector<TopicType>& samples,
+                     std::vector<DDS::SampleInfo>* infos,
+                     const std::string& topicName,
+                     const std::string& readerName,
+                     const int& maxSamples,
+                     const std::string& filter,
+                     const DDS::StringSeq& filterParams,
+                     const bool& readOnly,
+                     const ReadMode& mode,
+                     const char* info);
+
+    /**
+    * @brief Take or read ALIVE samples, using the cached query condition
+    *        when there is a filter.
+    * @return The status of the take or read.
+    */
+    template <typename TopicType>
+    DDS::ReturnCode_t takeFromReader(typename OpenDDS::DCPS::DDSTraits<TopicType>::DataReaderType* topicReader,
+                                     typename OpenDDS::DCPS::DDSTraits<TopicType>::MessageSequenceType& samples,
+                                     DDS::SampleInfoSeq& infos,
+                                     const int& maxSamples,
+                                     const std::string& topicName,
+                                     const std::string& readerName,
+                                     const std::string& filter,
+                                     const DDS::StringSeq& filterParams,
+                                     const bool& readOnly,
+                                     const DDS::SampleStateMask& sampleStates = DDS::ANY_SAMPLE_STATE,
+                                     const DDS::ViewStateMask& viewStates = DDS::ANY_VIEW_STATE);
+
+    /**
+    * @brief Apply a write operation to a batch of samples on one data writer.
+    * @param[in] samples Pointer to the first data sample.
+    * @param[in] count The number of data samples.
+    * @param[in] topicName The name of the topic.
+    * @param[in] coherent If true, wrap the batch in a coherent set.
+    * @param[in] operation Called with the typed writer, each sample and the
+    *            writer state (may be nullptr).
+    * @param[in] info Name of the calling method for error messages.
+    * @return True if the operation succeeded for every sample; false otherwise.
+    */
+    template <typename TopicType, typename Operation>
+    bool writeBatch(const TopicType* samples,
+                    const size_t& count,
+                    const std::string& topicName,
+                    const bool& coherent,
+                    Operation operation,
+                    const char* info);
+
+    /// Runs asynchronous callbacks of topics without their own executor.
+    std::shared_ptr<CallbackExecutor> m_executor;
+
+    /// Set while m_executor is the one created by the constructor.
+    bool m_ownsExecutor = false;
+
+    /// Executors assigned to single topics, keyed by topic name.
+    std::map<std::string, std::shared_ptr<CallbackExecutor>> m_topicExecutors;
 
     std::string ddsIP;
 
@@ -564,6 +1522,12 @@ private:
 
     int m_domainID;
 
+    /// Prepared query conditions kept per data reader.
+    size_t m_queryCacheCapacity = QueryConditionCache::DefaultCapacity;
+
+    /// Shared callback threads (see enableCallbackReactor).
+    std::shared_ptr<WaitSetReactor> m_reactor;
+
     std::string m_config;
     
     //Security parameters
@@ -597,6 +1561,10 @@ private:
 
 /**
  * @brief Return true if the samples are equal; otherwise false.
+ * @details Both samples are serialized into thread local buffers sized with
+ *          serialized_size, so no memory is allocated once the buffers have
+ *          grown to fit. Samples with different serialized sizes are unequal
+ *          without being serialized.
  * @remarks If we ever have a DDS utility class, this should go in there.
  * @param[in] lhs Left sample in compare.
  * @param[in] rhs Right sample in compare.
@@ -605,6 +1573,58 @@ private:
 template <typename TopicType>
 bool ddsSampleEquals(const TopicType& lhs, const TopicType& rhs);
 
+/**
+ * @brief Return a 64-bit hash of the serialized sample.
+ * @details Equal samples have equal hashes, so this can be used to detect
+ *          duplicate or unchanged samples. Uses a thread local buffer like
+ *          ddsSampleEquals.
+ * @param[in] sample The sample to hash.
+ * @return The hash value, or zero if the sample could not be serialized.
+ */
+template <typename TopicType>
+uint64_t ddsSampleHash(const TopicType& sample);
+
+/**
+ * @brief Serialize only the key members of a sample.
+ * @remarks If we ever have a DDS utility class, this should go in there.
+ * @param[in] sample Serialize the key of this sample.
+ * @param[out] block Receives the serialized key. The block is reset and
+ *             grown as needed, so it can be reused between calls.
+ * @return True if the key was serialized; otherwise false.
+ */
+template <typename TopicType>
+bool ddsSerializeKey(const TopicType& sample, ACE_Message_Block& block);
+
+/**
+ * @brief Serialize a sample for DDSManager::writeSerialized.
+ * @details Writes an encapsulation header and the sample using the
+ *          QosDictionary::getEncodingKind() encoding.
+ * @param[in] sample Serialize this sample.
+ * @param[out] block Receives the serialized sample. The block is reset and
+ *             grown as needed.
+ * @return True if the sample was serialized; otherwise false.
+ */
+template <typename TopicType>
+bool ddsSerializeSample(const TopicType& sample, ACE_Message_Block& block);
+
+/**
+ * @brief Return a 64-bit FNV-1a hash of a byte buffer.
+ * @param[in] data Pointer to the first byte.
+ * @param[in] size The number of bytes to hash.
+ * @return The hash value.
+ */
+inline uint64_t ddsHashBytes(const char* data, size_t size);
+
+/**
+ * @brief Return a process-wide index for a type.
+ * @details The same type always gets the same index and each new type gets
+ *          the next unused one, starting at zero. Defined in the library so
+ *          that every module of the process shares one table.
+ * @param[in] type The type to look up.
+ * @return The index of the type.
+ */
+size_t ddsTypeSlot(const std::type_index& type);
+
 #if defined (OPENDDW_PRECPP11)
 /**
  * @brief Get the string for a given enum value.
@@ -25,6 +25,7 @@
 #include "std_qosC.h"
 
 #include "dds_listeners.h"
+#include "qos_dictionary.h"
 
  //As of OpenDDS 3.13, we can rejoin domains after calling the destructor, but only if we don't call this function
  //until the end of the program
@@ -206,7 +207,23 @@ template <typename TopicType>
 bool DDSManager::takeSample(TopicType& sample,
                             const std::string& topicName,
                             const std::string& readerName,
-                            const std::string& filter)
+                            const std::string& filter,
+                            const DDS::StringSeq& filterParams)
+{
+    DDS::SampleInfo info;
+    return takeSample(sample, info, topicName, readerName, filter, filterParams);
+
+} // End DDSManager::takeSample
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::takeSample(TopicType& sample,
+                            DDS::SampleInfo& info,
+                            const std::string& topicName,
+                            const std::string& readerName,
+                            const std::string& filter,
+                            const DDS::StringSeq& filterParams)
 {
     DDS::DataReader_var dataReader = getReader(topicName, readerName);
     if (!dataReader)
@@ -232,36 +249,16 @@ bool DDSManager::takeSample(TopicType& sample,
         return false;
     }
 
-    // Did the user specify a read condition?
-    if (filter != "")
-    {
-        DDS::QueryCondition_var condition = topicReader->create_querycondition(
-            DDS::ANY_SAMPLE_STATE,
-            DDS::ANY_VIEW_STATE,
-            DDS::ALIVE_INSTANCE_STATE,
-            filter.c_str(),
-            DDS::StringSeq());
-
-        // Take a single ALIVE sample with the condition parameter
-        status = topicReader->take_w_condition(
-            msgList,
-            infoSeq,
-            1,
-            condition);
-
-        topicReader->delete_readcondition(condition);
-    }
-    else // No read condition
-    {
-        // Take a single ALIVE sample
-        status = topicReader->take(
-            msgList,
-            infoSeq,
-            1,
-            DDS::ANY_SAMPLE_STATE,
-            DDS::ANY_VIEW_STATE,
-            DDS::ALIVE_INSTANCE_STATE);
-    }
+    // Take a single ALIVE sample, with the read condition if there is one
+    status = takeFromReader<TopicType>(topicReader,
+        msgList,
+        infoSeq,
+        1,
+        topicName,
+        readerName,
+        filter,
+        filterParams,
+        false);
 
     // If we don't have any data, we're done
     checkStatus(status, "DDSManager::takeSample::take");
@@ -271,6 +268,7 @@ bool DDSManager::takeSample(TopicType& sample,
     }
 
     sample = msgList[0];
+    info = infoSeq[0];
 
     status = topicReader->return_loan(msgList, infoSeq);
     checkStatus(status, "DDSManager::takeSample::return_loan");
@@ -287,18 +285,221 @@ bool DDSManager::takeAllSamples(std::vector<TopicType>& samples,
                                 const std::string& topicName,
                                 const std::string& readerName,
                                 const std::string& filter,
-                                const bool& readOnly)
+                                const bool& readOnly,
+                                const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, nullptr, topicName, readerName, DDS::LENGTH_UNLIMITED,
+        filter, filterParams, readOnly, ReadMode::ALL, "DDSManager::takeAllSamples::take");
+
+} // End DDSManager::takeAllSamples
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::takeAllSamples(std::vector<TopicType>& samples,
+                                std::vector<DDS::SampleInfo>& infos,
+                                const std::string& topicName,
+                                const std::string& readerName,
+                                const std::string& filter,
+                                const bool& readOnly,
+                                const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, &infos, topicName, readerName, DDS::LENGTH_UNLIMITED,
+        filter, filterParams, readOnly, ReadMode::ALL, "DDSManager::takeAllSamples::take");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+LoanedSamples<TopicType> DDSManager::takeLoaned(const std::string& topicName,
+                                                const std::string& readerName,
+                                                const std::string& filter,
+                                                const int& maxSamples,
+                                                const DDS::StringSeq& filterParams)
+{
+    return loanSamples<TopicType>(topicName, readerName, filter, filterParams, maxSamples, false,
+        "DDSManager::takeLoaned::take");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+LoanedSamples<TopicType> DDSManager::readLoaned(const std::string& topicName,
+                                                const std::string& readerName,
+                                                const std::string& filter,
+                                                const int& maxSamples,
+                                                const DDS::StringSeq& filterParams)
+{
+    return loanSamples<TopicType>(topicName, readerName, filter, filterParams, maxSamples, true,
+        "DDSManager::readLoaned::read");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+LoanedSamples<TopicType> DDSManager::loanSamples(const std::string& topicName,
+                                                 const std::string& readerName,
+                                                 const std::string& filter,
+                                                 const DDS::StringSeq& filterParams,
+                                                 const int& maxSamples,
+                                                 const bool& readOnly,
+                                                 const char* info)
 {
     DDS::DataReader_var dataReader = getReader(topicName, readerName);
     if (!dataReader)
     {
-        return false;
+        return LoanedSamples<TopicType>();
     }
 
-    DDS::ReturnCode_t status = DDS::RETCODE_OK;
-    DDS::SampleInfoSeq infoSeq;
+    typename LoanedSamples<TopicType>::ReaderVar topicReader =
+        OpenDDS::DCPS::DDSTraits<TopicType>::DataReaderType::_narrow(dataReader);
 
-    typename OpenDDS::DCPS::DDSTraits<TopicType>::MessageSequenceType msgList;
+    if (!topicReader)
+    {
+        std::cerr << "Unable to cast '"
+            << topicName
+            << "' to data reader type"
+            << std::endl;
+
+        return LoanedSamples<TopicType>();
+    }
+
+    LoanedSamples<TopicType> loan(topicReader);
+    const DDS::ReturnCode_t status = takeFromReader<TopicType>(topicReader,
+        loan.samples(),
+        loan.infos(),
+        maxSamples,
+        topicName,
+        readerName,
+        filter,
+        filterParams,
+        readOnly);
+
+    // Nothing is loaned unless the take succeeded
+    checkStatus(status, info);
+    if (status != DDS::RETCODE_OK)
+    {
+        return LoanedSamples<TopicType>();
+    }
+
+    return loan;
+
+} // End DDSManager::loanSamples
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::takeInto(std::vector<TopicType>& samples,
+                          const std::string& topicName,
+                          const std::string& readerName,
+                          const int& maxSamples,
+                          const std::string& filter,
+                          const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, nullptr, topicName, readerName, maxSamples, filter, filterParams,
+        false, ReadMode::ALL, "DDSManager::takeInto::take");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::takeInto(std::vector<TopicType>& samples,
+                          std::vector<DDS::SampleInfo>& infos,
+                          const std::string& topicName,
+                          const std::string& readerName,
+                          const int& maxSamples,
+                          const std::string& filter,
+                          const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, &infos, topicName, readerName, maxSamples, filter, filterParams,
+        false, ReadMode::ALL, "DDSManager::takeInto::take");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::readInto(std::vector<TopicType>& samples,
+                          const std::string& topicName,
+                          const std::string& readerName,
+                          const int& maxSamples,
+                          const std::string& filter,
+                          const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, nullptr, topicName, readerName, maxSamples, filter, filterParams,
+        true, ReadMode::ALL, "DDSManager::readInto::read");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::readInto(std::vector<TopicType>& samples,
+                          const std::string& topicName,
+                          const std::string& readerName,
+                          const int& maxSamples,
+                          const ReadMode& mode,
+                          const std::string& filter,
+                          const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, nullptr, topicName, readerName, maxSamples, filter, filterParams,
+        true, mode, "DDSManager::readInto::read");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::readInto(std::vector<TopicType>& samples,
+                          std::vector<DDS::SampleInfo>& infos,
+                          const std::string& topicName,
+                          const std::string& readerName,
+                          const int& maxSamples,
+                          const ReadMode& mode,
+                          const std::string& filter,
+                          const DDS::StringSeq& filterParams)
+{
+    return copySamples(samples, &infos, topicName, readerName, maxSamples, filter, filterParams,
+        true, mode, "DDSManager::readInto::read");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::copySamples(std::vector<TopicType>& samples,
+                             std::vector<DDS::SampleInfo>* infos,
+                             const std::string& topicName,
+                             const std::string& readerName,
+                             const int& maxSamples,
+                             const std::string& filter,
+                             const DDS::StringSeq& filterParams,
+                             const bool& readOnly,
+                             const ReadMode& mode,
+                             const char* info)
+{
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::MessageSequenceType SampleSeq;
+
+    DDS::SampleStateMask sampleStates = DDS::ANY_SAMPLE_STATE;
+    DDS::ViewStateMask viewStates = DDS::ANY_VIEW_STATE;
+    switch (mode)
+    {
+    case ReadMode::NEW_SAMPLES:
+    case ReadMode::CHANGED_INSTANCES:
+        sampleStates = DDS::NOT_READ_SAMPLE_STATE;
+        break;
+    case ReadMode::NEW_INSTANCES:
+        viewStates = DDS::NEW_VIEW_STATE;
+        break;
+    default:
+        break;
+    }
+
+    // sample_rank counts the later samples of the same instance, so the
+    // latest sample of each instance has a rank of zero
+    const bool latestOnly = mode == ReadMode::CHANGED_INSTANCES;
+
+    DDS::DataReader_var dataReader = getReader(topicName, readerName);
+    if (!dataReader)
+    {
+        return false;
+    }
 
     typename OpenDDS::DCPS::DDSTraits<TopicType>::DataReaderType::_var_type topicReader =
         OpenDDS::DCPS::DDSTraits<TopicType>::DataReaderType::_narrow(dataReader);
@@ -313,121 +514,238 @@ bool DDSManager::takeAllSamples(std::vector<TopicType>& samples,
         return false;
     }
 
+    DDS::ReturnCode_t status = DDS::RETCODE_OK;
 
-    // Did the user specify a read/take condition?
-    if (filter != "")
+    if (maxSamples > 0)
     {
-        // Prepare the read/take condition
-        DDS::QueryCondition_var condition = topicReader->create_querycondition(
-            DDS::ANY_SAMPLE_STATE,
-            DDS::ANY_VIEW_STATE,
-            DDS::ALIVE_INSTANCE_STATE,
-            filter.c_str(),
-            DDS::StringSeq());
-
-        if (readOnly)
+        // A sequence which owns a buffer of at least maxSamples elements is
+        // filled with copies instead of a loan. Keep one per thread so the
+        // buffer is only allocated when the bound grows.
+        thread_local SampleSeq msgList;
+        thread_local DDS::SampleInfoSeq infoSeq;
+
+        const CORBA::ULong bound = static_cast<CORBA::ULong>(maxSamples);
+        if (msgList.maximum() < bound)
         {
-            // Read all ALIVE samples (with condition) and leave samples in
-            // the data reader
-            status = topicReader->read_w_condition(
-                msgList,
-                infoSeq,
-                DDS::LENGTH_UNLIMITED,
-                condition);
+            msgList = SampleSeq(bound);
+            infoSeq = DDS::SampleInfoSeq(bound);
         }
-        else
+
+        status = takeFromReader<TopicType>(topicReader,
+            msgList,
+            infoSeq,
+            maxSamples,
+            topicName,
+            readerName,
+            filter,
+            filterParams,
+            readOnly,
+            sampleStates,
+            viewStates);
+
+        checkStatus(status, info);
+        if (status != DDS::RETCODE_OK)
         {
-            // Take ALL the ALIVE samples (with condition)
-            status = topicReader->take_w_condition(
-                msgList,
-                infoSeq,
-                DDS::LENGTH_UNLIMITED,
-                condition);
+            return false;
         }
 
-        topicReader->delete_readcondition(condition);
-    }
-    else // Not using a read/take condition
-    {
-        if (readOnly)
+        // Callers keep their previous samples when there is no data
+        samples.clear();
+        if (infos)
         {
-            // Read all ALIVE samples and leave the samples in the data reader
-            status = topicReader->read(
-                msgList,
-                infoSeq,
-                DDS::LENGTH_UNLIMITED,
-                DDS::ANY_SAMPLE_STATE,
-                DDS::ANY_VIEW_STATE,
-                DDS::ALIVE_INSTANCE_STATE);
+            infos->clear();
         }
-        else // Take ALL the ALIVE samples
+
+        // The copies belong to us, so move them out
+        for (CORBA::ULong i = 0; i < msgList.length(); i++)
         {
-            status = topicReader->take(
-                msgList,
-                infoSeq,
-                DDS::LENGTH_UNLIMITED,
-                DDS::ANY_SAMPLE_STATE,
-                DDS::ANY_VIEW_STATE,
-                DDS::ALIVE_INSTANCE_STATE);
+            if (latestOnly && infoSeq[i].sample_rank != 0)
+            {
+                continue;
+            }
+
+            samples.emplace_back(std::move(msgList[i]));
+            if (infos)
+            {
+                infos->push_back(infoSeq[i]);
+            }
         }
+
+        return true;
     }
 
+    // Without a bound the data reader has to loan the samples
+    SampleSeq msgList;
+    DDS::SampleInfoSeq infoSeq;
 
-    // If we don't have any data, we're done
-    checkStatus(status, "DDSManager::takeAllSamples::take");
+    status = takeFromReader<TopicType>(topicReader,
+        msgList,
+        infoSeq,
+        maxSamples,
+        topicName,
+        readerName,
+        filter,
+        filterParams,
+        readOnly,
+        sampleStates,
+        viewStates);
+
+    checkStatus(status, info);
     if (status != DDS::RETCODE_OK)
     {
         return false;
     }
 
-    samples.resize(msgList.length());
-    for (int i = 0; i < (int) msgList.length(); i++)
+    samples.clear();
+    if (infos)
+    {
+        infos->clear();
+    }
+
+    for (CORBA::ULong i = 0; i < msgList.length(); i++)
     {
-        samples[i] = msgList[i];
+        if (latestOnly && infoSeq[i].sample_rank != 0)
+        {
+            continue;
+        }
+
+        samples.push_back(msgList[i]);
+        if (infos)
+        {
+            infos->push_back(infoSeq[i]);
+        }
     }
 
     status = topicReader->return_loan(msgList, infoSeq);
-    checkStatus(status, "DDSManager::takeAllSamples::return_loan");
+    checkStatus(status, "DDSManager::copySamples::return_loan");
 
-    // Report that we have new data by return true
     return true;
 
-} // End DDSManager::takeAllSamples
+} // End DDSManager::copySamples
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+DDS::ReturnCode_t DDSManager::takeFromReader(
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataReaderType* topicReader,
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::MessageSequenceType& samples,
+    DDS::SampleInfoSeq& infos,
+    const int& maxSamples,
+    const std::string& topicName,
+    const std::string& readerName,
+    const std::string& filter,
+    const DDS::StringSeq& filterParams,
+    const bool& readOnly,
+    const DDS::SampleStateMask& sampleStates,
+    const DDS::ViewStateMask& viewStates)
+{
+    // Did the user specify a read/take condition?
+    if (filter != "")
+    {
+        std::shared_ptr<QueryConditionCache::Entry> query = getQueryCondition(topicName,
+            readerName, topicReader, filter, filterParams, sampleStates, viewStates);
+        if (!query)
+        {
+            return DDS::RETCODE_BAD_PARAMETER;
+        }
+
+        std::lock_guard<std::mutex> queryLock(query->mutex());
+        DDS::ReturnCode_t status = query->bind(filterParams);
+        if (status != DDS::RETCODE_OK)
+        {
+            return status;
+        }
+
+        if (readOnly)
+        {
+            return topicReader->read_w_condition(
+                samples, infos, maxSamples, query->condition());
+        }
+
+        return topicReader->take_w_condition(
+            samples, infos, maxSamples, query->condition());
+    }
+
+    if (readOnly)
+    {
+        return topicReader->read(
+            samples,
+            infos,
+            maxSamples,
+            sampleStates,
+            viewStates,
+            DDS::ALIVE_INSTANCE_STATE);
+    }
+
+    return topicReader->take(
+        samples,
+        infos,
+        maxSamples,
+        sampleStates,
+        viewStates,
+        DDS::ALIVE_INSTANCE_STATE);
+
+} // End DDSManager::takeFromReader
 
 
 //------------------------------------------------------------------------------
 template <typename TopicType>
 bool DDSManager::writeSample(const TopicType& topicInstance,
                              const std::string& topicName)
+{
+    return writeSample(topicInstance, topicName, "");
+
+} // End DDSManager::writeSample
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::disposeSample(const TopicType& topicInstance,
+    const std::string& topicName)
+{
+    return disposeSample(topicInstance, topicName, "");
+
+} // End DDSManager::disposeSample
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::writeSample(const TopicType& topicInstance,
+                             const std::string& topicName,
+                             const std::string& writerName)
 {
     DDS::ReturnCode_t status = DDS::RETCODE_OK;
-    DDS::DataWriter_var writer = getWriter(topicName);
-    if (!writer)
+    std::shared_ptr<TopicWriterState> state;
+    bool conflate = false;
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type topicWriter =
+        getTypedWriter<TopicType>(topicName, &state, &conflate, writerName);
+
+    if (conflate)
     {
-        std::cerr << "Unable to find writer for '"
-            << topicName
-            << "'"
-            << std::endl;
-        return false;
+        return writeAsync(topicInstance, topicName);
     }
 
-    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type topicWriter =
-        OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_narrow(writer);
-
     if (!topicWriter)
     {
-        std::cerr << "Unable to cast '"
-            << topicName
-            << "' to data writer type"
-            << std::endl;
-
         return false;
     }
 
+    // Skip samples identical to the last one written for the instance
+    if (state && state->changeFilter.isUnchanged(topicInstance))
+    {
+        return true;
+    }
+
     try
     {
+        DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+        if (state && state->instanceCache.isEnabled())
+        {
+            handle = state->instanceCache.registerHandle(topicWriter.in(), topicInstance);
+        }
+
         //I believe OpenDDS has mutex protection. I don't think we need to add to it.
-        status = topicWriter->write(topicInstance, DDS::HANDLE_NIL);
+        status = topicWriter->write(topicInstance, handle);
     }
     catch (const std::runtime_error& error)
     {
@@ -439,6 +757,10 @@ bool DDSManager::writeSample(const TopicType& topicInstance,
 
     if (status != DDS::RETCODE_OK)
     {
+        if (state)
+        {
+            state->changeFilter.forget(topicInstance);
+        }
         checkStatus(status, "DDSManager::writeSample::write");
         return false;
     }
@@ -451,36 +773,41 @@ bool DDSManager::writeSample(const TopicType& topicInstance,
 //------------------------------------------------------------------------------
 template <typename TopicType>
 bool DDSManager::disposeSample(const TopicType& topicInstance,
-    const std::string& topicName)
+                               const std::string& topicName,
+                               const std::string& writerName)
 {
     DDS::ReturnCode_t status = DDS::RETCODE_OK;
-    DDS::DataWriter_var writer = getWriter(topicName);
-    if (!writer)
+    std::shared_ptr<TopicWriterState> state;
+    bool conflate = false;
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type topicWriter =
+        getTypedWriter<TopicType>(topicName, &state, &conflate, writerName);
+
+    // Write the pending samples first so the dispose is not overtaken
+    if (conflate)
     {
-        std::cerr << "Unable to find writer for '"
-            << topicName
-            << "'"
-            << std::endl;
-        return false;
+        flush(topicName);
+        topicWriter = getTypedWriter<TopicType>(topicName, &state);
     }
 
-    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type topicWriter =
-        OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_narrow(writer);
-
     if (!topicWriter)
     {
-        std::cerr << "Unable to cast '"
-            << topicName
-            << "' to data writer type"
-            << std::endl;
-
         return false;
     }
 
     try
     {
+        DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+        if (state && state->instanceCache.isEnabled())
+        {
+            handle = state->instanceCache.evictHandle(topicInstance);
+        }
+        if (state)
+        {
+            state->changeFilter.forget(topicInstance);
+        }
+
         //I believe OpenDDS has mutex protection. I don't think we need to add to it.
-        status = topicWriter->dispose(topicInstance, DDS::HANDLE_NIL);
+        status = topicWriter->dispose(topicInstance, handle);
     }
     catch (const std::runtime_error& error)
     {
@@ -500,42 +827,1209 @@ bool DDSManager::disposeSample(const TopicType& topicInstance,
 
 } // End DDSManager::disposeSample
 
+
 //------------------------------------------------------------------------------
 template <typename TopicType>
-bool ddsSampleEquals(const TopicType& lhs, const TopicType& rhs)
+typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type
+DDSManager::getTypedWriter(const std::string& topicName,
+                           std::shared_ptr<TopicWriterState>* state,
+                           bool* conflate,
+                           const std::string& writerName) const
 {
-    const size_t maxSize = sizeof(TopicType);
-    ACE_Message_Block blockA(maxSize);
-    ACE_Message_Block blockB(maxSize);
-
-    OpenDDS::DCPS::Serializer serialA(&blockA, OpenDDS::DCPS::Encoding::Kind::KIND_UNALIGNED_CDR, false);
-    OpenDDS::DCPS::Serializer serialB(&blockB, OpenDDS::DCPS::Encoding::Kind::KIND_UNALIGNED_CDR, false);
-
-    serialA << lhs;
-    serialB << rhs;
-
-    if (blockA.length() != blockB.length())
+    DDS::DataWriter_var writer;
     {
-        return false;
+        decltype(m_sharedLock) lock(m_topicMutex);
+        auto iter = m_topics.find(topicName);
+        if (iter != m_topics.end() && iter->second != nullptr)
+        {
+            if (writerName.empty())
+            {
+                writer = iter->second->writer;
+                if (state)
+                {
+                    *state = iter->second->writerState;
+                }
+                if (conflate)
+                {
+                    *conflate = iter->second->conflateWrites;
+                }
+            }
+            else
+            {
+                // Named writers are never conflated
+                auto writerIter = iter->second->writers.find(writerName);
+                auto stateIter = iter->second->writerStates.find(writerName);
+                if (writerIter != iter->second->writers.end() &&
+                    stateIter != iter->second->writerStates.end())
+                {
+                    writer = writerIter->second;
+                    if (state)
+                    {
+                        *state = stateIter->second;
+                    }
+                }
+            }
+        }
     }
 
-    return (memcmp(blockA.base(), blockB.base(), blockA.length()) == 0);
-}
-
-#if defined (OPENDDW_PRECPP11)
-//------------------------------------------------------------------------------
-template <typename TopicType>
-bool ddsInit(TopicType& topicInstance)
-{
-    const size_t maxSize = sizeof(topicInstance);
-    char* cdrBuffer = new char[maxSize];
-    memset(cdrBuffer, 0, maxSize);
-    TAO_InputCDR cdrInput(cdrBuffer, maxSize);
-
-    bool pass = (cdrInput >> topicInstance);
-    if (!pass)
+    if (conflate && *conflate)
     {
-        std::cerr << "Failed to initialize topic" << std::endl;
+        return nullptr;
+    }
+
+    if (!writer)
+    {
+        std::cerr << "Unable to find writer for '"
+            << topicName
+            << (writerName.empty() ? "" : "' named '")
+            << writerName
+            << "'"
+            << std::endl;
+        return nullptr;
+    }
+
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type topicWriter =
+        OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_narrow(writer);
+
+    if (!topicWriter)
+    {
+        std::cerr << "Unable to cast '"
+            << topicName
+            << "' to data writer type"
+            << std::endl;
+    }
+
+    return topicWriter;
+
+} // End DDSManager::getTypedWriter
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType, typename Operation>
+bool DDSManager::writeBatch(const TopicType* samples,
+                            const size_t& count,
+                            const std::string& topicName,
+                            const bool& coherent,
+                            Operation operation,
+                            const char* info)
+{
+    if (count == 0)
+    {
+        return true;
+    }
+
+    if (!samples)
+    {
+        return false;
+    }
+
+    std::shared_ptr<TopicWriterState> state;
+    bool conflate = false;
+    typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type topicWriter =
+        getTypedWriter<TopicType>(topicName, &state, &conflate);
+
+    // Batches bypass conflation; write the pending samples first
+    if (conflate)
+    {
+        flush(topicName);
+        topicWriter = getTypedWriter<TopicType>(topicName, &state);
+    }
+
+    if (!topicWriter)
+    {
+        return false;
+    }
+
+    // Start the coherent set on the publisher that owns this writer. Never
+    // write a batch that asked for a coherent set without one.
+    DDS::Publisher_var publisher;
+    if (coherent)
+    {
+        publisher = getPublisher(topicName);
+        if (!publisher)
+        {
+            std::cerr << "Unable to write a coherent set on '"
+                << topicName
+                << "': no publisher"
+                << std::endl;
+            return false;
+        }
+
+        const DDS::ReturnCode_t status = publisher->begin_coherent_changes();
+        if (status != DDS::RETCODE_OK)
+        {
+            std::cerr << "Unable to begin coherent changes on '"
+                << topicName
+                << "': "
+                << getErrorName(status)
+                << ". Is presentation.coherent_access enabled?"
+                << std::endl;
+            return false;
+        }
+    }
+
+    bool pass = true;
+    for (size_t i = 0; i < count; i++)
+    {
+        DDS::ReturnCode_t status = DDS::RETCODE_OK;
+        try
+        {
+            status = operation(topicWriter.in(), samples[i], state.get());
+        }
+        catch (const std::runtime_error& error)
+        {
+            std::cerr << "\n!!! Caught exception in " << info << " !!!"
+                << "\n!!! Error: " << error.what() << " !!!\n"
+                << std::endl;
+            pass = false;
+        }
+
+        if (status != DDS::RETCODE_OK)
+        {
+            checkStatus(status, info);
+            pass = false;
+        }
+    }
+
+    if (publisher)
+    {
+        const DDS::ReturnCode_t status = publisher->end_coherent_changes();
+        if (status != DDS::RETCODE_OK)
+        {
+            checkStatus(status, info);
+            pass = false;
+        }
+    }
+
+    return pass;
+
+} // End DDSManager::writeBatch
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::writeSamples(const TopicType* samples,
+                              const size_t& count,
+                              const std::string& topicName,
+                              const bool& coherent)
+{
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType WriterType;
+
+    return writeBatch(samples, count, topicName, coherent,
+        [](WriterType* topicWriter, const TopicType& sample, TopicWriterState* state)
+        {
+            if (state && state->changeFilter.isUnchanged(sample))
+            {
+                return DDS::ReturnCode_t(DDS::RETCODE_OK);
+            }
+
+            const DDS::InstanceHandle_t handle =
+                state ? state->instanceCache.registerHandle(topicWriter, sample) : DDS::HANDLE_NIL;
+            const DDS::ReturnCode_t status = topicWriter->write(sample, handle);
+            if (status != DDS::RETCODE_OK && state)
+            {
+                state->changeFilter.forget(sample);
+            }
+            return status;
+        },
+        "DDSManager::writeSamples::write");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::writeSamples(const std::vector<TopicType>& samples,
+                              const std::string& topicName,
+                              const bool& coherent)
+{
+    return writeSamples(samples.data(), samples.size(), topicName, coherent);
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::disposeSamples(const TopicType* samples,
+                                const size_t& count,
+                                const std::string& topicName,
+                                const bool& coherent)
+{
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType WriterType;
+
+    return writeBatch(samples, count, topicName, coherent,
+        [](WriterType* topicWriter, const TopicType& sample, TopicWriterState* state)
+        {
+            DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+            if (state)
+            {
+                if (state->instanceCache.isEnabled())
+                {
+                    handle = state->instanceCache.evictHandle(sample);
+                }
+                state->changeFilter.forget(sample);
+            }
+            return topicWriter->dispose(sample, handle);
+        },
+        "DDSManager::disposeSamples::dispose");
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::disposeSamples(const std::vector<TopicType>& samples,
+                                const std::string& topicName,
+                                const bool& coherent)
+{
+    return disposeSamples(samples.data(), samples.size(), topicName, coherent);
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+TopicWriter<TopicType> DDSManager::getTopicWriter(const std::string& topicName)
+{
+    return getTopicWriter<TopicType>(topicName, std::string());
+
+} // End DDSManager::getTopicWriter
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+TopicWriter<TopicType> DDSManager::getTopicWriter(const std::string& topicName,
+                                                  const std::string& writerName)
+{
+    decltype(m_sharedLock) lock(m_topicMutex);
+    auto iter = m_topics.find(topicName);
+
+    DDS::DataWriter_var writer;
+    std::shared_ptr<TopicWriterState> state;
+    if (iter != m_topics.end() && iter->second != nullptr)
+    {
+        if (writerName.empty())
+        {
+            writer = iter->second->writer;
+            state = iter->second->writerState;
+        }
+        else
+        {
+            auto writerIter = iter->second->writers.find(writerName);
+            auto stateIter = iter->second->writerStates.find(writerName);
+            if (writerIter != iter->second->writers.end() &&
+                stateIter != iter->second->writerStates.end())
+            {
+                writer = writerIter->second;
+                state = stateIter->second;
+            }
+        }
+    }
+
+    if (!writer || !state)
+    {
+        std::cerr << "Unable to find writer for '"
+            << topicName
+            << (writerName.empty() ? "" : "' named '")
+            << writerName
+            << "'"
+            << std::endl;
+        return TopicWriter<TopicType>();
+    }
+
+    typename TopicWriter<TopicType>::WriterVar topicWriter =
+        OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_narrow(writer);
+
+    if (!topicWriter)
+    {
+        std::cerr << "Unable to cast '"
+            << topicName
+            << "' to data writer type"
+            << std::endl;
+
+        return TopicWriter<TopicType>();
+    }
+
+    return TopicWriter<TopicType>(state, topicWriter, topicName);
+
+} // End DDSManager::getTopicWriter
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::writeAsync(const TopicType& sample, const std::string& topicName)
+{
+    std::shared_ptr<AsyncWriter<TopicType>> asyncWriter;
+
+    {
+        decltype(m_sharedLock) lock(m_topicMutex);
+        auto iter = m_topics.find(topicName);
+        if (iter != m_topics.end() && iter->second && iter->second->asyncWriter)
+        {
+            asyncWriter = std::static_pointer_cast<AsyncWriter<TopicType>>(iter->second->asyncWriter);
+        }
+    }
+
+    // Create the queue and sender thread on first use
+    if (!asyncWriter)
+    {
+        decltype(m_uniqueLock) lock(m_topicMutex);
+        auto iter = m_topics.find(topicName);
+        if (iter == m_topics.end() ||
+            iter->second == nullptr ||
+            !iter->second->writer ||
+            !iter->second->writerState)
+        {
+            std::cerr << "Unable to find writer for '"
+                << topicName
+                << "'"
+                << std::endl;
+            return false;
+        }
+
+        std::shared_ptr<TopicGroup> topicGroup = iter->second;
+        if (!topicGroup->asyncWriter)
+        {
+            typename TopicWriter<TopicType>::WriterVar topicWriter =
+                OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_narrow(topicGroup->writer);
+
+            if (!topicWriter)
+            {
+                std::cerr << "Unable to cast '"
+                    << topicName
+                    << "' to data writer type"
+                    << std::endl;
+
+                return false;
+            }
+
+            topicGroup->asyncWriter = std::make_shared<AsyncWriter<TopicType>>(
+                TopicWriter<TopicType>(topicGroup->writerState, topicWriter, topicName),
+                topicGroup->asyncCapacity,
+                topicGroup->asyncPolicy,
+                topicGroup->asyncFlushInterval);
+        }
+
+        asyncWriter = std::static_pointer_cast<AsyncWriter<TopicType>>(topicGroup->asyncWriter);
+    }
+
+    return asyncWriter->write(sample);
+
+} // End DDSManager::writeAsync
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+size_t DDSManager::writeSerializedFanout(const TopicType& sample,
+    const std::vector<std::pair<DDSManager*, std::string>>& destinations)
+{
+    // A new block for each call, since the replayers keep references to it
+    ACE_Message_Block payload;
+    if (!ddsSerializeSample(sample, payload))
+    {
+        std::cerr << "Unable to serialize sample for fan-out" << std::endl;
+        return 0;
+    }
+
+    size_t written = 0;
+    for (const auto& destination : destinations)
+    {
+        if (destination.first && destination.first->writeSerialized(destination.second, payload))
+        {
+            written++;
+        }
+    }
+
+    return written;
+
+} // End DDSManager::writeSerializedFanout
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool TopicWriter<TopicType>::write(const TopicType& sample)
+{
+    if (!m_state || !m_state->acquire())
+    {
+        std::cerr << "Unable to write to '"
+            << m_topicName
+            << "'. The topic writer is no longer valid."
+            << std::endl;
+        return false;
+    }
+
+    if (m_state->changeFilter.isUnchanged(sample))
+    {
+        m_state->release();
+        return true;
+    }
+
+    DDS::ReturnCode_t status = DDS::RETCODE_OK;
+    try
+    {
+        DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+        if (m_state->instanceCache.isEnabled())
+        {
+            handle = m_state->instanceCache.registerHandle(m_writer.in(), sample);
+        }
+
+        status = m_writer->write(sample, handle);
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "\n!!! Caught exception in TopicWriter::write !!!"
+            << "\n!!! An invalid data reader filter is most likely the issue. !!!"
+            << "\n!!! Error: " << error.what() << " !!!\n"
+            << std::endl;
+    }
+    if (status != DDS::RETCODE_OK)
+    {
+        m_state->changeFilter.forget(sample);
+    }
+    m_state->release();
+
+    if (status != DDS::RETCODE_OK)
+    {
+        DDSManager::checkStatus(status, "TopicWriter::write");
+        return false;
+    }
+
+    return true;
+
+} // End TopicWriter::write
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool TopicWriter<TopicType>::dispose(const TopicType& sample)
+{
+    if (!m_state || !m_state->acquire())
+    {
+        std::cerr << "Unable to dispose on '"
+            << m_topicName
+            << "'. The topic writer is no longer valid."
+            << std::endl;
+        return false;
+    }
+
+    DDS::ReturnCode_t status = DDS::RETCODE_OK;
+    try
+    {
+        DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+        if (m_state->instanceCache.isEnabled())
+        {
+            handle = m_state->instanceCache.evictHandle(sample);
+        }
+        m_state->changeFilter.forget(sample);
+
+        status = m_writer->dispose(sample, handle);
+    }
+    catch (const std::runtime_error& error)
+    {
+        std::cerr << "\n!!! Caught exception in TopicWriter::dispose !!!"
+            << "\n!!! An invalid data reader filter is most likely the issue. !!!"
+            << "\n!!! Error: " << error.what() << " !!!\n"
+            << std::endl;
+    }
+    m_state->release();
+
+    if (status != DDS::RETCODE_OK)
+    {
+        DDSManager::checkStatus(status, "TopicWriter::dispose");
+        return false;
+    }
+
+    return true;
+
+} // End TopicWriter::dispose
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void LoanedSamples<TopicType>::returnLoan()
+{
+    if (!m_loan)
+    {
+        return;
+    }
+
+    if (m_loan->reader && m_loan->samples.length() > 0)
+    {
+        DDS::ReturnCode_t status = m_loan->reader->return_loan(m_loan->samples, m_loan->infos);
+        DDSManager::checkStatus(status, "LoanedSamples::return_loan");
+    }
+
+    m_loan.reset();
+
+} // End LoanedSamples::returnLoan
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool ddsSampleEquals(const TopicType& lhs, const TopicType& rhs)
+{
+    const OpenDDS::DCPS::Encoding encoding(OpenDDS::DCPS::Encoding::KIND_UNALIGNED_CDR);
+
+    const size_t sizeA = OpenDDS::DCPS::serialized_size(encoding, lhs);
+    if (sizeA != OpenDDS::DCPS::serialized_size(encoding, rhs))
+    {
+        return false;
+    }
+
+    // Reuse the buffers on this thread; they only grow
+    thread_local ACE_Message_Block blockA;
+    thread_local ACE_Message_Block blockB;
+    blockA.reset();
+    blockB.reset();
+    if ((blockA.size() < sizeA && blockA.size(sizeA) != 0) ||
+        (blockB.size() < sizeA && blockB.size(sizeA) != 0))
+    {
+        return false;
+    }
+
+    OpenDDS::DCPS::Serializer serialA(&blockA, encoding);
+    OpenDDS::DCPS::Serializer serialB(&blockB, encoding);
+    if (!(serialA << lhs) || !(serialB << rhs))
+    {
+        return false;
+    }
+
+    if (blockA.length() != blockB.length())
+    {
+        return false;
+    }
+
+    return (memcmp(blockA.rd_ptr(), blockB.rd_ptr(), blockA.length()) == 0);
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+uint64_t ddsSampleHash(const TopicType& sample)
+{
+    const OpenDDS::DCPS::Encoding encoding(OpenDDS::DCPS::Encoding::KIND_UNALIGNED_CDR);
+    const size_t sampleSize = OpenDDS::DCPS::serialized_size(encoding, sample);
+
+    thread_local ACE_Message_Block block;
+    block.reset();
+    if (block.size() < sampleSize && block.size(sampleSize) != 0)
+    {
+        return 0;
+    }
+
+    OpenDDS::DCPS::Serializer serializer(&block, encoding);
+    if (!(serializer << sample))
+    {
+        return 0;
+    }
+
+    return ddsHashBytes(block.rd_ptr(), block.length());
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool ddsSerializeKey(const TopicType& sample, ACE_Message_Block& block)
+{
+    const OpenDDS::DCPS::Encoding encoding(OpenDDS::DCPS::Encoding::KIND_UNALIGNED_CDR);
+    const OpenDDS::DCPS::KeyOnly<const TopicType> key(sample);
+
+    const size_t keySize = OpenDDS::DCPS::serialized_size(encoding, key);
+    block.reset();
+    if (block.size() < keySize && block.size(keySize) != 0)
+    {
+        return false;
+    }
+
+    OpenDDS::DCPS::Serializer serializer(&block, encoding);
+    return (serializer << key);
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool ddsSerializeSample(const TopicType& sample, ACE_Message_Block& block)
+{
+    const OpenDDS::DCPS::Encoding encoding(QosDictionary::getEncodingKind());
+
+    OpenDDS::DCPS::EncapsulationHeader encapsulation;
+    if (!encapsulation.from_encoding(encoding, OpenDDS::DCPS::MarshalTraits<TopicType>::extensibility()))
+    {
+        return false;
+    }
+
+    const size_t sampleSize = OpenDDS::DCPS::EncapsulationHeader::serialized_size +
+        OpenDDS::DCPS::serialized_size(encoding, sample);
+    block.reset();
+    if (block.size() < sampleSize && block.size(sampleSize) != 0)
+    {
+        return false;
+    }
+
+    OpenDDS::DCPS::Serializer serializer(&block, encoding);
+    return (serializer << encapsulation) && (serializer << sample);
+}
+
+//------------------------------------------------------------------------------
+inline uint64_t ddsHashBytes(const char* data, size_t size)
+{
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType, typename WriterType>
+DDS::InstanceHandle_t InstanceHandleCache::registerHandle(WriterType* writer,
+                                                          const TopicType& sample)
+{
+    if (!isEnabled() || !writer)
+    {
+        return DDS::HANDLE_NIL;
+    }
+
+    // Reuse the key buffer on this thread to keep the lookup allocation free
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(sample, keyBlock))
+    {
+        return DDS::HANDLE_NIL;
+    }
+
+    const uint64_t hash = ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length());
+    DDS::InstanceHandle_t handle = DDS::HANDLE_NIL;
+    if (find(hash, keyBlock.rd_ptr(), keyBlock.length(), handle))
+    {
+        return handle;
+    }
+
+    handle = writer->register_instance(sample);
+    if (handle != DDS::HANDLE_NIL)
+    {
+        insert(hash, keyBlock.rd_ptr(), keyBlock.length(), handle);
+    }
+
+    return handle;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+DDS::InstanceHandle_t InstanceHandleCache::evictHandle(const TopicType& sample)
+{
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(sample, keyBlock))
+    {
+        return DDS::HANDLE_NIL;
+    }
+
+    return erase(ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length()),
+                 keyBlock.rd_ptr(),
+                 keyBlock.length());
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+AsyncWriter<TopicType>::AsyncWriter(const TopicWriter<TopicType>& writer,
+                                    size_t capacity,
+                                    OverflowPolicy policy,
+                                    std::chrono::nanoseconds flushInterval) :
+    m_writer(writer),
+    m_policy(policy),
+    m_capacity(capacity > 0 ? capacity : 1),
+    m_flushInterval(flushInterval),
+    m_queue(policy == OverflowPolicy::CONFLATE ? 1 : m_capacity),
+    m_pendingCount(0),
+    m_running(true),
+    m_senderWaiting(false),
+    m_producersWaiting(0)
+{
+    if (m_policy == OverflowPolicy::CONFLATE)
+    {
+        m_pending.reserve(m_capacity);
+        m_draining.reserve(m_capacity);
+    }
+
+    m_thread = std::thread(&AsyncWriter<TopicType>::run, this);
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+AsyncWriter<TopicType>::~AsyncWriter()
+{
+    stop();
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool AsyncWriter<TopicType>::write(const TopicType& sample)
+{
+    if (!m_running.load())
+    {
+        return false;
+    }
+
+    if (m_policy == OverflowPolicy::CONFLATE)
+    {
+        if (!conflate(sample))
+        {
+            return false;
+        }
+    }
+    else
+    {
+        while (!m_queue.push(sample))
+        {
+            if (m_policy == OverflowPolicy::DROP_NEWEST)
+            {
+                m_dropped++;
+                return false;
+            }
+
+            if (m_policy == OverflowPolicy::DROP_OLDEST)
+            {
+                TopicType oldest;
+                if (m_queue.pop(oldest))
+                {
+                    m_dropped++;
+                }
+                continue;
+            }
+
+            // OverflowPolicy::BLOCK
+            std::unique_lock<std::mutex> lock(m_producerMutex);
+            m_producersWaiting++;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            m_producerCondition.wait(lock, [this]
+            {
+                return !m_queue.full() || !m_running.load();
+            });
+            m_producersWaiting--;
+
+            if (!m_running.load())
+            {
+                m_dropped++;
+                return false;
+            }
+        }
+    }
+
+    m_enqueued++;
+
+    // stop may have flipped m_running after the check above, and the sender
+    // thread may already have made its final drain, so write it here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_running.load())
+    {
+        drain();
+        return true;
+    }
+
+    notifySender();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void AsyncWriter<TopicType>::stop()
+{
+    if (m_running.exchange(false))
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_senderMutex);
+            m_senderCondition.notify_all();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_producerMutex);
+            m_producerCondition.notify_all();
+        }
+    }
+
+    if (m_thread.joinable() && m_thread.get_id() != std::this_thread::get_id())
+    {
+        m_thread.join();
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool AsyncWriter<TopicType>::flush()
+{
+    if (!m_running.load())
+    {
+        return false;
+    }
+
+    drain();
+    return true;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void AsyncWriter<TopicType>::run()
+{
+    while (m_running.load())
+    {
+        drain();
+        const auto lastDrain = std::chrono::steady_clock::now();
+
+        std::unique_lock<std::mutex> lock(m_senderMutex);
+        m_senderWaiting.store(true);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        m_senderCondition.wait(lock, [this]
+        {
+            return hasPending() || !m_running.load();
+        });
+        m_senderWaiting.store(false);
+
+        // Let samples collect until the flush interval has passed
+        if (m_flushInterval > std::chrono::nanoseconds::zero())
+        {
+            m_senderCondition.wait_until(lock, lastDrain + m_flushInterval, [this]
+            {
+                return !m_running.load();
+            });
+        }
+    }
+
+    // Write anything queued before stop was called
+    drain();
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void AsyncWriter<TopicType>::drain()
+{
+    std::lock_guard<std::mutex> drainLock(m_drainMutex);
+
+    if (m_policy == OverflowPolicy::CONFLATE)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_conflateMutex);
+            m_draining.swap(m_pending);
+            m_pendingIndex.clear();
+            m_pendingCount.store(0);
+        }
+
+        for (auto& entry : m_draining)
+        {
+            if (m_writer.write(entry.second))
+            {
+                m_drained++;
+            }
+            else
+            {
+                m_failed++;
+            }
+        }
+        m_draining.clear();
+        return;
+    }
+
+    TopicType sample;
+    while (m_queue.pop(sample))
+    {
+        notifyProducers();
+        if (m_writer.write(sample))
+        {
+            m_drained++;
+        }
+        else
+        {
+            m_failed++;
+        }
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool AsyncWriter<TopicType>::hasPending() const
+{
+    if (m_policy == OverflowPolicy::CONFLATE)
+    {
+        return m_pendingCount.load() > 0;
+    }
+
+    return !m_queue.empty();
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void AsyncWriter<TopicType>::notifySender()
+{
+    // Pairs with the fence in run() so a sample queued while the sender is
+    // going to sleep is never missed
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_senderWaiting.load())
+    {
+        std::lock_guard<std::mutex> lock(m_senderMutex);
+        m_senderCondition.notify_one();
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void AsyncWriter<TopicType>::notifyProducers()
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_producersWaiting.load() > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_producerMutex);
+        m_producerCondition.notify_all();
+    }
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool AsyncWriter<TopicType>::conflate(const TopicType& sample)
+{
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(sample, keyBlock))
+    {
+        m_dropped++;
+        return false;
+    }
+
+    const char* key = keyBlock.rd_ptr();
+    const size_t keySize = keyBlock.length();
+    const uint64_t hash = ddsHashBytes(key, keySize);
+
+    std::lock_guard<std::mutex> lock(m_conflateMutex);
+    auto iter = m_pendingIndex.find(hash);
+    if (iter != m_pendingIndex.end() &&
+        m_pending[iter->second].first.compare(0, std::string::npos, key, keySize) == 0)
+    {
+        // Replace the queued sample for this instance
+        m_pending[iter->second].second = sample;
+        m_dropped++;
+        return true;
+    }
+
+    if (m_pending.size() >= m_capacity)
+    {
+        m_dropped++;
+        return false;
+    }
+
+    // A key whose hash collides with another pending key is queued without
+    // an index entry, so later samples of that key are not conflated
+    if (iter == m_pendingIndex.end())
+    {
+        m_pendingIndex.emplace(hash, m_pending.size());
+    }
+
+    m_pending.emplace_back(std::string(key, keySize), sample);
+    m_pendingCount.store(m_pending.size());
+    return true;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool ChangeFilter::isUnchanged(const TopicType& sample)
+{
+    if (!isEnabled())
+    {
+        return false;
+    }
+
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(sample, keyBlock))
+    {
+        return false;
+    }
+
+    const uint64_t keyHash = ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length());
+    const uint64_t sampleHash = ddsSampleHash(sample);
+    if (sampleHash == 0)
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto result = m_lastHash.emplace(keyHash, sampleHash);
+    if (!result.second)
+    {
+        if (result.first->second == sampleHash)
+        {
+            m_suppressed++;
+            return true;
+        }
+        result.first->second = sampleHash;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void ChangeFilter::forget(const TopicType& sample)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(sample, keyBlock))
+    {
+        return;
+    }
+
+    const uint64_t keyHash = ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length());
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_lastHash.erase(keyHash);
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+typename LastValueCache<TopicType>::ValuePtr
+LastValueCache<TopicType>::get(const TopicType& key) const
+{
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(key, keyBlock))
+    {
+        return nullptr;
+    }
+
+    const uint64_t hash = ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length());
+    const std::shared_ptr<const Index> index = std::atomic_load(&shardOf(hash));
+    auto range = index->equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter)
+    {
+        if (iter->second->key.compare(0, std::string::npos, keyBlock.rd_ptr(), keyBlock.length()) == 0)
+        {
+            return std::atomic_load(&iter->second->value);
+        }
+    }
+
+    return nullptr;
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void LastValueCache<TopicType>::update(const TopicType& sample, const DDS::SampleInfo& info)
+{
+    if (info.instance_state == DDS::NOT_ALIVE_DISPOSED_INSTANCE_STATE ||
+        info.instance_state == DDS::NOT_ALIVE_NO_WRITERS_INSTANCE_STATE)
+    {
+        erase(sample, info.instance_handle);
+        return;
+    }
+
+    if (!info.valid_data)
+    {
+        return;
+    }
+
+    ValuePtr value = std::make_shared<const TopicType>(sample);
+
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    // Instances already seen by this reader skip the key serialization
+    std::shared_ptr<Slot>& slot = m_handleSlots[info.instance_handle];
+    if (!slot)
+    {
+        thread_local ACE_Message_Block keyBlock;
+        if (!ddsSerializeKey(sample, keyBlock))
+        {
+            m_handleSlots.erase(info.instance_handle);
+            return;
+        }
+
+        const uint64_t hash = ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length());
+        std::shared_ptr<const Index>& shard = shardOf(hash);
+        const std::shared_ptr<const Index> index = std::atomic_load(&shard);
+        auto range = index->equal_range(hash);
+        for (auto iter = range.first; iter != range.second && !slot; ++iter)
+        {
+            if (iter->second->key.compare(0, std::string::npos, keyBlock.rd_ptr(), keyBlock.length()) == 0)
+            {
+                slot = iter->second;
+            }
+        }
+
+        // Publish a new shard with the new instance
+        if (!slot)
+        {
+            slot = std::make_shared<Slot>();
+            slot->key.assign(keyBlock.rd_ptr(), keyBlock.length());
+            slot->handle = info.instance_handle;
+
+            auto newIndex = std::make_shared<Index>(*index);
+            newIndex->emplace(hash, slot);
+            std::atomic_store(&shard, std::shared_ptr<const Index>(std::move(newIndex)));
+            m_size.fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    std::atomic_store(&slot->value, std::move(value));
+    m_version.fetch_add(1, std::memory_order_release);
+}
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+void LastValueCache<TopicType>::erase(const TopicType& key, DDS::InstanceHandle_t handle)
+{
+    thread_local ACE_Message_Block keyBlock;
+    if (!ddsSerializeKey(key, keyBlock))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_updateMutex);
+
+    const uint64_t hash = ddsHashBytes(keyBlock.rd_ptr(), keyBlock.length());
+    std::shared_ptr<const Index>& shard = shardOf(hash);
+    const std::shared_ptr<const Index> index = std::atomic_load(&shard);
+    auto range = index->equal_range(hash);
+    std::shared_ptr<Slot> slot;
+    for (auto iter = range.first; iter != range.second && !slot; ++iter)
+    {
+        if (iter->second->key.compare(0, std::string::npos, keyBlock.rd_ptr(), keyBlock.length()) == 0)
+        {
+            slot = iter->second;
+        }
+    }
+
+    // The handle may be reused for another instance, so never keep it
+    if (handle != DDS::HANDLE_NIL)
+    {
+        m_handleSlots.erase(handle);
+    }
+
+    if (!slot)
+    {
+        return;
+    }
+
+    if (slot->handle != DDS::HANDLE_NIL)
+    {
+        m_handleSlots.erase(slot->handle);
+    }
+
+    // Publish a new shard without the instance
+    auto newIndex = std::make_shared<Index>(*index);
+    auto newRange = newIndex->equal_range(hash);
+    for (auto iter = newRange.first; iter != newRange.second; ++iter)
+    {
+        if (iter->second == slot)
+        {
+            newIndex->erase(iter);
+            break;
+        }
+    }
+    std::atomic_store(&shard, std::shared_ptr<const Index>(std::move(newIndex)));
+    m_size.fetch_sub(1, std::memory_order_release);
+    m_version.fetch_add(1, std::memory_order_release);
+}
+
+#if defined (OPENDDW_PRECPP11)
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool ddsInit(TopicType& topicInstance)
+{
+    const size_t maxSize = sizeof(topicInstance);
+    char* cdrBuffer = new char[maxSize];
+    memset(cdrBuffer, 0, maxSize);
+    TAO_InputCDR cdrInput(cdrBuffer, maxSize);
+
+    bool pass = (cdrInput >> topicInstance);
+    if (!pass)
+    {
+        std::cerr << "Failed to initialize topic" << std::endl;
     }
 
     delete[] cdrBuffer;
@@ -549,40 +2043,189 @@ bool DDSManager::addCallback(const std::string& topicName,
                              const std::string& readerName,
                              std::function<void(const TopicType&)> func,
                              const bool& queueMessages,
-                             const bool& asyncHandling)
+                             const bool& asyncHandling,
+                             EmitterBase::CallbackId* callbackId)
 {
-    decltype(m_sharedLock) lock(m_topicMutex);
-    auto iter = m_topics.find(topicName);
+    return addEmitterCallback<TopicType>(topicName, readerName,
+        [&func](Emitter<TopicType>& emitter) { return emitter.addCallback(func); },
+        queueMessages, asyncHandling, false, callbackId);
+}
 
-    if (iter == m_topics.end())
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::addCallbackWithInfo(const std::string& topicName,
+                                     const std::string& readerName,
+                                     std::function<void(const TopicType&, const DDS::SampleInfo&)> func,
+                                     const bool& queueMessages,
+                                     const bool& asyncHandling,
+                                     EmitterBase::CallbackId* callbackId)
+{
+    return addEmitterCallback<TopicType>(topicName, readerName,
+        [&func](Emitter<TopicType>& emitter) { return emitter.addCallback(func); },
+        queueMessages, asyncHandling, false, callbackId);
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::addBatchCallback(const std::string& topicName,
+                                  const std::string& readerName,
+                                  std::function<void(const SampleBatch<TopicType>&)> func,
+                                  const bool& queueMessages,
+                                  const bool& asyncHandling,
+                                  EmitterBase::CallbackId* callbackId)
+{
+    return addEmitterCallback<TopicType>(topicName, readerName,
+        [&func](Emitter<TopicType>& emitter) { return emitter.addBatchCallback(func); },
+        queueMessages, asyncHandling, false, callbackId);
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+bool DDSManager::addLifecycleCallback(const std::string& topicName,
+                                      const std::string& readerName,
+                                      std::function<void(const TopicType&)> onDisposed,
+                                      std::function<void(const TopicType&)> onNoWriters,
+                                      const int& purgeDelay,
+                                      const bool& queueMessages,
+                                      const bool& asyncHandling,
+                                      EmitterBase::CallbackId* callbackId)
+{
+    if (purgeDelay >= 0)
     {
-        return false;
+        DDS::DataReader_var reader = getReader(topicName, readerName);
+        if (!reader)
+        {
+            return false;
+        }
+
+        // Drop the instances the reader still holds after the delay
+        DDS::DataReaderQos qos;
+        reader->get_qos(qos);
+        DDS::Duration_t delay;
+        delay.sec = purgeDelay / 1000;
+        delay.nanosec = static_cast<CORBA::ULong>(purgeDelay % 1000) * 1000000; // ms to ns
+        qos.reader_data_lifecycle.autopurge_nowriter_samples_delay = delay;
+        qos.reader_data_lifecycle.autopurge_disposed_samples_delay = delay;
+
+        const DDS::ReturnCode_t status = reader->set_qos(qos);
+        checkStatus(status, "DDSManager::addLifecycleCallback::set_qos");
+        if (status != DDS::RETCODE_OK)
+        {
+            return false;
+        }
+    }
+
+    return addEmitterCallback<TopicType>(topicName, readerName,
+        [&onDisposed, &onNoWriters](Emitter<TopicType>& emitter) {
+            return emitter.addLifecycleCallback(onDisposed, onNoWriters);
+        },
+        queueMessages, asyncHandling, false, callbackId);
+}
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType>
+std::shared_ptr<const LastValueCache<TopicType>>
+DDSManager::createLastValueCache(const std::string& topicName,
+                                 const std::string& readerName)
+{
+    auto cache = std::make_shared<LastValueCache<TopicType>>();
+
+    // Lifecycle callbacks make the emitter take the samples of disposed and
+    // no writers instances too, which remove the instances from the cache
+    std::function<void(const TopicType&, const DDS::SampleInfo&)> onSample =
+        [cache](const TopicType& sample, const DDS::SampleInfo& info) {
+            cache->update(sample, info);
+        };
+    std::function<void(const TopicType&)> onRemoved =
+        [cache](const TopicType& key) {
+            cache->erase(key);
+        };
+
+    const bool added = addEmitterCallback<TopicType>(topicName, readerName,
+        [&onSample, &onRemoved](Emitter<TopicType>& emitter) {
+            emitter.addLifecycleCallback(onRemoved, onRemoved);
+            return emitter.addCallback(onSample);
+        },
+        false, false, true);
+
+    if (!added)
+    {
+        std::cerr << "Unable to create a last value cache for '"
+            << topicName
+            << "' with the data reader named '"
+            << readerName
+            << "'. The data reader must exist and have no callbacks."
+            << std::endl;
+
+        return nullptr;
     }
 
+    return cache;
+
+} // End DDSManager::createLastValueCache
+
+
+//------------------------------------------------------------------------------
+template <typename TopicType, typename Registration>
+bool DDSManager::addEmitterCallback(const std::string& topicName,
+                                    const std::string& readerName,
+                                    Registration registerCallback,
+                                    const bool& queueMessages,
+                                    const bool& asyncHandling,
+                                    const bool& exclusive,
+                                    EmitterBase::CallbackId* callbackId)
+{
+    // Takes the topic lock itself
     DDS::DataReader_var reader = getReader(topicName, readerName);
     if (!reader)
     {
         return false;
     }
 
+    // Exclusive, since the emitter is found or created in one step
+    decltype(m_uniqueLock) lock(m_topicMutex);
+    auto iter = m_topics.find(topicName);
+
+    if (iter == m_topics.end())
+    {
+        return false;
+    }
+
     std::shared_ptr<TopicGroup> topicGroup = iter->second;
     if (!topicGroup)
     {
         return false;
     }
 
-    Emitter<TopicType>* emitter = nullptr;
+    std::shared_ptr<Emitter<TopicType>> emitter;
 
-    if (topicGroup->emitters.find(readerName) != topicGroup->emitters.end())
+    auto emitterIter = topicGroup->emitters.find(readerName);
+    if (emitterIter != topicGroup->emitters.end())
     {
-        emitter = static_cast<Emitter<TopicType>*>(topicGroup->emitters[readerName].get());
+        if (exclusive)
+        {
+            return false;
+        }
+
+        emitter = std::static_pointer_cast<Emitter<TopicType>>(emitterIter->second);
     }
     else
     {
-        emitter = new Emitter<TopicType>(reader, m_dispatcher);
+        auto executor = m_topicExecutors.find(topicName);
+        emitter = std::make_shared<Emitter<TopicType>>(reader,
+            executor != m_topicExecutors.end() ? executor->second : m_executor);
+        emitter->setReactor(m_reactor);
         topicGroup->emitters.emplace(readerName, emitter);
     }
-    emitter->addCallback(func);
+    const EmitterBase::CallbackId id = registerCallback(*emitter);
+    if (callbackId)
+    {
+        *callbackId = id;
+    }
     emitter->setAsync(asyncHandling);
     lock.unlock();
 
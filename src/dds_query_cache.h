@@ -0,0 +1,275 @@
+#ifndef __DDS_QUERY_CACHE_H__
+#define __DDS_QUERY_CACHE_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DdsDcpsSubscriptionC.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Counters for the query conditions cached for a data reader.
+ */
+struct QueryCacheStatistics
+{
+    /// Lookups which found a prepared query condition.
+    uint64_t hits = 0;
+    /// Lookups which created a new query condition.
+    uint64_t misses = 0;
+    /// Query conditions deleted to stay within the capacity.
+    uint64_t evictions = 0;
+    /// Query conditions currently cached.
+    size_t size = 0;
+};
+
+
+/**
+ * @brief Prepared query conditions of a data reader, keyed by expression.
+ *
+ * @details Creating a query condition parses its expression, so creating and
+ *          deleting one for every filtered take is expensive. The cache keeps
+ *          the condition of each expression and reuses it. A parameterized
+ *          expression ("x > %0") is prepared once; a take with different
+ *          parameters rebinds them with set_query_parameters. The least
+ *          recently used condition is deleted when the cache is full.
+ */
+class QueryConditionCache
+{
+public:
+
+    /// The default maximum number of query conditions per data reader.
+    static constexpr size_t DefaultCapacity = 16;
+
+    /**
+     * @brief A prepared query condition.
+     * @details The condition is deleted from its data reader when the last
+     *          reference goes away, so a condition evicted while another
+     *          thread is taking with it stays valid until that take is done.
+     */
+    class Entry
+    {
+    public:
+
+        Entry(DDS::DataReader_ptr reader,
+              DDS::QueryCondition_ptr condition,
+              const DDS::StringSeq& params) :
+            m_reader(DDS::DataReader::_duplicate(reader)),
+            m_condition(condition)
+        {
+            m_params.reserve(params.length());
+            for (CORBA::ULong i = 0; i < params.length(); i++)
+            {
+                m_params.emplace_back(params[i].in());
+            }
+        }
+
+        ~Entry()
+        {
+            m_reader->delete_readcondition(m_condition.in());
+        }
+
+        Entry(const Entry&) = delete;
+        Entry& operator=(const Entry&) = delete;
+
+        DDS::QueryCondition_ptr condition() const
+        {
+            return m_condition.in();
+        }
+
+        /// Serializes parameter binding and the take which uses it.
+        std::mutex& mutex()
+        {
+            return m_mutex;
+        }
+
+        /**
+         * @brief Bind new query parameters unless they are already bound.
+         * @remarks Hold mutex() until the take with these parameters is done.
+         * @param[in] params The query parameters.
+         * @return The result of set_query_parameters or DDS::RETCODE_OK.
+         */
+        DDS::ReturnCode_t bind(const DDS::StringSeq& params)
+        {
+            bool same = m_params.size() == params.length();
+            for (CORBA::ULong i = 0; same && i < params.length(); i++)
+            {
+                same = m_params[i] == params[i].in();
+            }
+
+            if (same)
+            {
+                return DDS::RETCODE_OK;
+            }
+
+            const DDS::ReturnCode_t status = m_condition->set_query_parameters(params);
+            if (status == DDS::RETCODE_OK)
+            {
+                m_params.clear();
+                for (CORBA::ULong i = 0; i < params.length(); i++)
+                {
+                    m_params.emplace_back(params[i].in());
+                }
+            }
+
+            return status;
+        }
+
+    private:
+
+        DDS::DataReader_var m_reader;
+        DDS::QueryCondition_var m_condition;
+        std::mutex m_mutex;
+
+        /// The parameters currently bound to the condition.
+        std::vector<std::string> m_params;
+    };
+
+    explicit QueryConditionCache(size_t capacity = DefaultCapacity) :
+        m_capacity(capacity)
+    {}
+
+    QueryConditionCache(const QueryConditionCache&) = delete;
+    QueryConditionCache& operator=(const QueryConditionCache&) = delete;
+
+    /**
+     * @brief Get the prepared condition for an expression, creating it on a miss.
+     * @details Conditions select ALIVE samples. The same expression with
+     *          different sample or view states is a different condition.
+     * @param[in] reader The data reader the condition belongs to.
+     * @param[in] expression The query expression.
+     * @param[in] params The query parameters used if the condition is created.
+     * @param[in] sampleStates The sample states the condition selects.
+     * @param[in] viewStates The view states the condition selects.
+     * @return The prepared condition, or nullptr if it could not be created.
+     */
+    std::shared_ptr<Entry> acquire(DDS::DataReader_ptr reader,
+                                   const std::string& expression,
+                                   const DDS::StringSeq& params,
+                                   DDS::SampleStateMask sampleStates = DDS::ANY_SAMPLE_STATE,
+                                   DDS::ViewStateMask viewStates = DDS::ANY_VIEW_STATE)
+    {
+        // Most conditions use any state, so only build a key for the others
+        std::string stateKey;
+        const bool anyState = sampleStates == DDS::ANY_SAMPLE_STATE &&
+                              viewStates == DDS::ANY_VIEW_STATE;
+        if (!anyState)
+        {
+            stateKey = expression + "\n" + std::to_string(sampleStates) + "/" + std::to_string(viewStates);
+        }
+        const std::string& key = anyState ? expression : stateKey;
+
+        std::shared_ptr<Entry> evicted;
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto iter = m_index.find(key);
+        if (iter != m_index.end())
+        {
+            m_stats.hits++;
+            m_entries.splice(m_entries.begin(), m_entries, iter->second);
+            return iter->second->second;
+        }
+
+        m_stats.misses++;
+        DDS::QueryCondition_var condition = reader->create_querycondition(
+            sampleStates,
+            viewStates,
+            DDS::ALIVE_INSTANCE_STATE,
+            expression.c_str(),
+            params);
+
+        if (!condition)
+        {
+            return nullptr;
+        }
+
+        auto entry = std::make_shared<Entry>(reader, condition._retn(), params);
+
+        // A capacity of zero still keeps the latest condition
+        if (m_entries.size() >= std::max<size_t>(m_capacity, 1))
+        {
+            evicted = evictOne();
+        }
+
+        m_entries.emplace_front(key, entry);
+        m_index[key] = m_entries.begin();
+        return entry;
+    }
+
+    /**
+     * @brief Change the maximum number of cached conditions.
+     * @remarks Conditions beyond the new capacity are deleted right away.
+     * @param[in] capacity The new maximum. Zero caches only the latest.
+     */
+    void setCapacity(size_t capacity)
+    {
+        std::list<std::shared_ptr<Entry>> evicted;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_capacity = capacity;
+        while (m_entries.size() > std::max<size_t>(m_capacity, 1))
+        {
+            evicted.push_back(evictOne());
+        }
+    }
+
+    /// Delete all cached conditions.
+    void clear()
+    {
+        EntryList entries;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_index.clear();
+        entries.swap(m_entries);
+    }
+
+    QueryCacheStatistics getStatistics() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        QueryCacheStatistics stats = m_stats;
+        stats.size = m_entries.size();
+        return stats;
+    }
+
+private:
+
+    /// Remove the least recently used entry. The caller deletes it unlocked.
+    std::shared_ptr<Entry> evictOne()
+    {
+        std::shared_ptr<Entry> entry = std::move(m_entries.back().second);
+        m_index.erase(m_entries.back().first);
+        m_entries.pop_back();
+        m_stats.evictions++;
+        return entry;
+    }
+
+    typedef std::list<std::pair<std::string, std::shared_ptr<Entry>>> EntryList;
+
+    mutable std::mutex m_mutex;
+
+    size_t m_capacity;
+
+    /// Most recently used first.
+    EntryList m_entries;
+
+    std::unordered_map<std::string, EntryList::iterator> m_index;
+
+    QueryCacheStatistics m_stats;
+};
+
+#endif
+
+/**
+ * @}
+ */
@@ -0,0 +1,85 @@
+#ifndef __DDS_SAMPLE_BATCH_H__
+#define __DDS_SAMPLE_BATCH_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/TypeSupportImpl.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include "dds_sample_iterator.h"
+
+/**
+ * @brief The samples of one take, passed to a batch callback.
+ *
+ * @details A view of the sample and SampleInfo sequences of a take, so a
+ *          callback can process every sample of the take at once (such as
+ *          one database transaction or index update per take). Synchronous
+ *          batch callbacks view the loaned sequences without any copy.
+ *          Asynchronous batch callbacks view one copy shared by every batch
+ *          callback of the take.
+ * @remarks The view is only valid during the callback. Samples with
+ *          SampleInfo::valid_data set to false only have their key fields set.
+ */
+template <typename TopicType>
+class SampleBatch
+{
+public:
+
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::MessageSequenceType SampleSeq;
+
+    /// Iterates over the samples of the batch.
+    typedef SampleIterator<SampleBatch, TopicType> const_iterator;
+
+    SampleBatch(const SampleSeq& samples, const DDS::SampleInfoSeq& infos) :
+        m_samples(samples), m_infos(infos)
+    {}
+
+    /// The number of samples in the batch.
+    size_t size() const
+    {
+        return m_samples.length();
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    /// The sample at an index. The index must be less than size().
+    const TopicType& operator[](size_t index) const
+    {
+        return m_samples[static_cast<CORBA::ULong>(index)];
+    }
+
+    /// The SampleInfo of the sample at an index.
+    const DDS::SampleInfo& info(size_t index) const
+    {
+        return m_infos[static_cast<CORBA::ULong>(index)];
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, size());
+    }
+
+private:
+
+    const SampleSeq& m_samples;
+    const DDS::SampleInfoSeq& m_infos;
+};
+
+#endif
+
+/**
+ * @}
+ */
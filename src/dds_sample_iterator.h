@@ -0,0 +1,90 @@
+#ifndef __DDS_SAMPLE_ITERATOR_H__
+#define __DDS_SAMPLE_ITERATOR_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/TypeSupportImpl.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <cstddef>
+#include <iterator>
+
+/**
+ * @brief Random access iterator over the samples of a sample view.
+ *
+ * @details Used as the const_iterator of LoanedSamples and SampleBatch. The
+ *          iterator holds the view and an index, so the view only has to
+ *          provide operator[](size_t) for the samples and info(size_t) for
+ *          their SampleInfo.
+ * @remarks Iterators of different views must not be compared.
+ */
+template <typename Owner, typename TopicType>
+class SampleIterator
+{
+public:
+    typedef std::random_access_iterator_tag iterator_category;
+    typedef TopicType value_type;
+    typedef std::ptrdiff_t difference_type;
+    typedef const TopicType* pointer;
+    typedef const TopicType& reference;
+
+    SampleIterator() :
+        m_owner(nullptr), m_index(0)
+    {}
+
+    SampleIterator(const Owner* owner, size_t index) :
+        m_owner(owner), m_index(index)
+    {}
+
+    reference operator*() const { return (*m_owner)[m_index]; }
+    pointer operator->() const { return &(*m_owner)[m_index]; }
+    reference operator[](difference_type n) const { return (*m_owner)[offset(n)]; }
+
+    SampleIterator& operator++() { ++m_index; return *this; }
+    SampleIterator operator++(int) { SampleIterator temp(*this); ++m_index; return temp; }
+    SampleIterator& operator--() { --m_index; return *this; }
+    SampleIterator operator--(int) { SampleIterator temp(*this); --m_index; return temp; }
+
+    SampleIterator& operator+=(difference_type n) { m_index = offset(n); return *this; }
+    SampleIterator& operator-=(difference_type n) { m_index = offset(-n); return *this; }
+    SampleIterator operator+(difference_type n) const { return SampleIterator(m_owner, offset(n)); }
+    SampleIterator operator-(difference_type n) const { return SampleIterator(m_owner, offset(-n)); }
+    friend SampleIterator operator+(difference_type n, const SampleIterator& it) { return it + n; }
+
+    difference_type operator-(const SampleIterator& other) const
+    {
+        return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+    }
+
+    bool operator==(const SampleIterator& other) const { return m_index == other.m_index; }
+    bool operator!=(const SampleIterator& other) const { return m_index != other.m_index; }
+    bool operator<(const SampleIterator& other) const { return m_index < other.m_index; }
+    bool operator>(const SampleIterator& other) const { return m_index > other.m_index; }
+    bool operator<=(const SampleIterator& other) const { return m_index <= other.m_index; }
+    bool operator>=(const SampleIterator& other) const { return m_index >= other.m_index; }
+
+    /// The SampleInfo of the current sample.
+    const DDS::SampleInfo& info() const { return m_owner->info(m_index); }
+
+private:
+
+    /// The index n samples away from the current one.
+    size_t offset(difference_type n) const
+    {
+        return static_cast<size_t>(static_cast<difference_type>(m_index) + n);
+    }
+
+    const Owner* m_owner;
+    size_t m_index;
+};
+
+#endif
+
+/**
+ * @}
+ */
@@ -5,8 +5,10 @@
 #include "std_qosC.h"
 #include <typeinfo>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <unordered_set>
+#include <vector>
 #include <future>
 #include <shared_mutex>
 
@@ -102,9 +104,8 @@ public:
             return false;
         }
 
-        decltype(m_uniqueLock) lck(mutex_shr);
         //Let's try something sneaky, so we don't have to pass topicName when we write DDS messages
-        m_pubMap[typeid(T).name()] = topicName;
+        SetTopicSlot<T>(m_pubSlots, topicName);
         return true;
     }
 
@@ -121,7 +122,7 @@ public:
         }
         bool temp = createSubscriber(topicName, rName, filter);
 
-        m_subMap[typeid(T).name()] = topicName;
+        SetTopicSlot<T>(m_subSlots, topicName);
         return temp;
     }
 
@@ -152,7 +153,7 @@ public:
             sstr << "Failed to add callback for topic:" << topicName << ".";
             m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
         }
-        m_subMap[typeid(TopicType).name()] = topicName;
+        SetTopicSlot<TopicType>(m_subSlots, topicName);
         return retVal;
     }
 
@@ -189,46 +190,57 @@ public:
     template <class T>
     bool Write(const T& message, std::string topicName = "")
     {
-        std::string tName = topicName;
-
-        if (tName.empty()) {
-            decltype(m_sharedLock) lck(mutex_shr);
-            auto itr = m_pubMap.find(typeid(T).name());
-            if (itr == m_pubMap.end()) {
-                std::stringstream sstr;
-                sstr << "Trying to publish a DDS type that has no topic mapped:" << typeid(T).name() << ".";
-                m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
-                return false;
-            }
-            else {
-                //l.debug("Publishing topic: %s.", typeid(T).name());
-                tName = itr->second;
-            }
+        if (!topicName.empty()) {
+            return writeSample<T>(message, topicName);
         }
-        return writeSample<T>(message, tName);
+
+        // The snapshot keeps the topic name alive while we write
+        const auto slots = std::atomic_load(&m_pubSlots);
+        const std::string* tName = FindTopicSlot<T>(slots);
+        if (tName == nullptr) {
+            std::stringstream sstr;
+            sstr << "Trying to publish a DDS type that has no topic mapped:" << typeid(T).name() << ".";
+            m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
+            return false;
+        }
+        return writeSample<T>(message, *tName);
     }
 
+    /// Same as Write, but queues the message for a sender thread (see DDSManager::writeAsync).
     template <class T>
-    bool Dispose(const T& message, std::string topicName = "")
+    bool WriteAsync(const T& message, std::string topicName = "")
     {
-        std::string tName = topicName;
+        if (!topicName.empty()) {
+            return writeAsync<T>(message, topicName);
+        }
 
-        if (tName.empty()) {
-            decltype(m_sharedLock) lck(mutex_shr);
-            auto itr = m_pubMap.find(typeid(T).name());
-            if (itr == m_pubMap.end()) {
+        const auto slots = std::atomic_load(&m_pubSlots);
+        const std::string* tName = FindTopicSlot<T>(slots);
+        if (tName == nullptr) {
+            std::stringstream sstr;
+            sstr << "Trying to publish a DDS type that has no topic mapped:" << typeid(T).name() << ".";
+            m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
+            return false;
+        }
+        return writeAsync<T>(message, *tName);
+    }
 
-                std::stringstream sstr;
-                sstr << "Trying to dispose a DDS type that has no topic mapped:" << typeid(T).name() << ".";
-                m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
-                return false;
-            }
-            else {
-                //l.debug("Publishing topic: %s.", typeid(T).name());
-                tName = itr->second;
-            }
+    template <class T>
+    bool Dispose(const T& message, std::string topicName = "")
+    {
+        if (!topicName.empty()) {
+            return disposeSample<T>(message, topicName);
+        }
+
+        const auto slots = std::atomic_load(&m_pubSlots);
+        const std::string* tName = FindTopicSlot<T>(slots);
+        if (tName == nullptr) {
+            std::stringstream sstr;
+            sstr << "Trying to dispose a DDS type that has no topic mapped:" << typeid(T).name() << ".";
+            m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
+            return false;
         }
-        return disposeSample<T>(message, tName);
+        return disposeSample<T>(message, *tName);
     }
 
     // WaitOnDiscovery's name has been changed, but we don't want to pull the rug out from people too hard.
@@ -268,11 +280,11 @@ public:
         auto startTime = std::chrono::steady_clock::now();
         std::string topic_name = typeid(T).name();
         try {
-            decltype(m_sharedLock) lck(mutex_shr);
-            auto iter = m_pubMap.find(topic_name);
+            const auto slots = std::atomic_load(&m_pubSlots);
+            const std::string* slotName = FindTopicSlot<T>(slots);
 
             std::stringstream sstr;
-            if (iter == m_pubMap.end()) {
+            if (slotName == nullptr) {
                 sstr << "No Publisher found for: " << topic_name << ".";
                 m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
                 return false;
@@ -282,8 +294,7 @@ public:
             m_messageHandler(LogMessageType::DDS_INFO, sstr.str());
             sstr.flush();
 
-            std::string temp = iter->second;
-            lck.unlock();
+            std::string temp = *slotName;
             auto dw = getWriter(temp);
 
             if (dw == nullptr) {
@@ -332,17 +343,13 @@ public:
     {
         std::string topic_name = typeid(T).name();
         try {
-            std::string temp;
-            {
-                decltype(m_sharedLock) lck(mutex_shr);
-                auto iter = m_pubMap.find(topic_name);
-                if (iter == m_pubMap.end()) {
-                    return std::string("Invalid Publisher for ") + topic_name;
-                }
-
-                temp = iter->second;
+            const auto slots = std::atomic_load(&m_pubSlots);
+            const std::string* slotName = FindTopicSlot<T>(slots);
+            if (slotName == nullptr) {
+                return std::string("Invalid Publisher for ") + topic_name;
             }
-            return getWriterAddress(temp);
+
+            return getWriterAddress(*slotName);
         }
         catch (...) {
         }
@@ -359,11 +366,11 @@ public:
         std::string topic_name = typeid(T).name();
 
         try {
-            decltype(m_sharedLock) lck(mutex_shr);
-            auto iter = m_subMap.find(topic_name);
+            const auto slots = std::atomic_load(&m_subSlots);
+            const std::string* slotName = FindTopicSlot<T>(slots);
 
             std::stringstream sstr;
-            if (iter == m_subMap.end()) {
+            if (slotName == nullptr) {
                 sstr << "No subscriber found for: " << topic_name << ".";
                 m_messageHandler(LogMessageType::DDS_ERROR, sstr.str());
                 return false;
@@ -373,8 +380,7 @@ public:
             m_messageHandler(LogMessageType::DDS_INFO, sstr.str());
             sstr.flush();
 
-            std::string temp = iter->second;
-            lck.unlock();
+            std::string temp = *slotName;
 
             auto genReaderName = GenerateReaderName(temp, reader_name);
 
@@ -425,15 +431,12 @@ public:
     {
         std::string topic_name = typeid(T).name();
         try {
-            std::string temp;
-            {
-                decltype(m_sharedLock) lck(mutex_shr);
-                auto iter = m_subMap.find(topic_name);
-                if (iter == m_subMap.end()) {
-                    return std::string("Invalid Subscriber for ") + topic_name;
-                }
-                temp = iter->second;
+            const auto slots = std::atomic_load(&m_subSlots);
+            const std::string* slotName = FindTopicSlot<T>(slots);
+            if (slotName == nullptr) {
+                return std::string("Invalid Subscriber for ") + topic_name;
             }
+            std::string temp = *slotName;
 
             return getReaderAddress(temp, GenerateReaderName(temp, reader_name)); // Reader name == Topic name + "Reader", unless user-specified
         }
@@ -453,13 +456,17 @@ private:
     ///eventID, then you should not use ddsWrite;
     int m_eventID;
 
-    ///This publishing map is built up by calling ddsPublisher. Now you can call ddsWrite
-    ///without having to specify the topicName. UNLESS you are publishing multiple topic names for the same DDS struct
-    std::map<std::string, std::string> m_pubMap;
+    ///Topic names indexed by TypeSlot<T>(). An empty name means the type has no topic.
+    typedef std::vector<std::string> TopicSlots;
+
+    ///This publishing table is built up by calling ddsPublisher. Now you can call ddsWrite
+    ///without having to specify the topicName. UNLESS you are publishing multiple topic names for the same DDS struct.
+    ///The table is copy-on-write: readers take a snapshot with std::atomic_load and never lock.
+    std::shared_ptr<const TopicSlots> m_pubSlots;
 
-    ///The subscriber map is built when calling Callback<> or Subscriber<>. It keeps a list of all topics that the manager
+    ///The subscriber table is built when calling Callback<> or Subscriber<>. It keeps a list of all topics that the manager
     ///is subscribed to; useful when determining of there is a publisher of a given topic.
-    std::map<std::string, std::string> m_subMap;
+    std::shared_ptr<const TopicSlots> m_subSlots;
 
     std::shared_mutex mutex_shr;
     std::unique_lock<decltype(mutex_shr)> m_sharedLock;
@@ -472,6 +479,41 @@ private:
         return readerName.empty() ? topicName + "Reader" : readerName;
     }
 
+    // The index of type T in the topic tables, assigned by the library on first use
+    template <class T>
+    static size_t TypeSlot()
+    {
+        static const size_t slot = ddsTypeSlot(typeid(T));
+        return slot;
+    }
+
+    // Returns the topic mapped to type T in a table snapshot, or nullptr if there is none
+    template <class T>
+    static const std::string* FindTopicSlot(const std::shared_ptr<const TopicSlots>& slots)
+    {
+        const size_t slot = TypeSlot<T>();
+        if (!slots || slot >= slots->size() || (*slots)[slot].empty()) {
+            return nullptr;
+        }
+        return &(*slots)[slot];
+    }
+
+    // Copy the table, map type T to topicName and publish the new table
+    template <class T>
+    void SetTopicSlot(std::shared_ptr<const TopicSlots>& slots, const std::string& topicName)
+    {
+        const size_t slot = TypeSlot<T>();
+
+        decltype(m_uniqueLock) lck(mutex_shr);
+        const auto current = std::atomic_load(&slots);
+        auto updated = current ? std::make_shared<TopicSlots>(*current) : std::make_shared<TopicSlots>();
+        if (updated->size() <= slot) {
+            updated->resize(slot + 1);
+        }
+        (*updated)[slot] = topicName;
+        std::atomic_store(&slots, std::shared_ptr<const TopicSlots>(std::move(updated)));
+    }
+
 }; //End of DDSSimpleManager class
 
 
@@ -0,0 +1,362 @@
+#ifndef __DDS_TOPIC_WRITER_H__
+#define __DDS_TOPIC_WRITER_H__
+
+#ifdef WIN32
+#pragma warning(push, 0)  //No DDS warnings
+#endif
+
+#include <dds/DCPS/TypeSupportImpl.h>
+
+#ifdef WIN32
+#pragma warning(pop)
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+/**
+ * @brief Opt-in cache of registered instance handles for a keyed topic.
+ *
+ * @details Writing with DDS::HANDLE_NIL makes OpenDDS marshal and look up the
+ *          key of every sample. When enabled, the first write of a key
+ *          registers the instance and stores the handle under a hash of the
+ *          serialized key, so later writes of that key pass the cached handle.
+ *          Disposing of a sample evicts its key. Keys whose hash collides with
+ *          a different cached key fall back to DDS::HANDLE_NIL.
+ */
+class InstanceHandleCache
+{
+public:
+
+    InstanceHandleCache() : m_enabled(false)
+    {}
+
+    /**
+     * @brief Turn the cache on or off. Turning it off clears all entries.
+     * @param[in] value True to enable the cache.
+     */
+    void enable(bool value)
+    {
+        m_enabled.store(value);
+        if (!value)
+        {
+            clear();
+        }
+    }
+
+    bool isEnabled() const
+    {
+        return m_enabled.load();
+    }
+
+    /// The number of cached instance handles.
+    size_t size() const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        return m_handles.size();
+    }
+
+    void clear()
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_handles.clear();
+    }
+
+    /**
+     * @brief Get the instance handle for a sample, registering it on first use.
+     * @param[in] writer The typed data writer used to register the instance.
+     * @param[in] sample The sample containing the instance key.
+     * @return The cached instance handle or DDS::HANDLE_NIL if the cache is
+     *         disabled or the key could not be cached.
+     */
+    template <typename TopicType, typename WriterType>
+    DDS::InstanceHandle_t registerHandle(WriterType* writer, const TopicType& sample);
+
+    /**
+     * @brief Remove the instance handle for a sample from the cache.
+     * @param[in] sample The sample containing the instance key.
+     * @return The instance handle which was cached or DDS::HANDLE_NIL.
+     */
+    template <typename TopicType>
+    DDS::InstanceHandle_t evictHandle(const TopicType& sample);
+
+private:
+
+    /// Find a cached handle. The key is compared to guard against hash collisions.
+    bool find(uint64_t hash, const char* key, size_t size, DDS::InstanceHandle_t& handle) const
+    {
+        std::shared_lock<std::shared_mutex> lock(m_mutex);
+        auto iter = m_handles.find(hash);
+        if (iter == m_handles.end() ||
+            iter->second.key.compare(0, std::string::npos, key, size) != 0)
+        {
+            return false;
+        }
+
+        handle = iter->second.handle;
+        return true;
+    }
+
+    /// Cache a handle unless a different key already uses the hash.
+    void insert(uint64_t hash, const char* key, size_t size, DDS::InstanceHandle_t handle)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        m_handles.emplace(hash, Entry{ std::string(key, size), handle });
+    }
+
+    /// Remove a cached handle. Returns DDS::HANDLE_NIL if it was not cached.
+    DDS::InstanceHandle_t erase(uint64_t hash, const char* key, size_t size)
+    {
+        std::unique_lock<std::shared_mutex> lock(m_mutex);
+        auto iter = m_handles.find(hash);
+        if (iter == m_handles.end() ||
+            iter->second.key.compare(0, std::string::npos, key, size) != 0)
+        {
+            return DDS::HANDLE_NIL;
+        }
+
+        const DDS::InstanceHandle_t handle = iter->second.handle;
+        m_handles.erase(iter);
+        return handle;
+    }
+
+    struct Entry
+    {
+        /// The serialized key, kept to detect hash collisions.
+        std::string key;
+        DDS::InstanceHandle_t handle;
+    };
+
+    std::atomic<bool> m_enabled;
+
+    mutable std::shared_mutex m_mutex;
+
+    /// The key is the hash of the serialized instance key.
+    std::unordered_map<uint64_t, Entry> m_handles;
+};
+
+/**
+ * @brief Opt-in filter that skips writes of unchanged samples.
+ *
+ * @details Keeps a hash of the last sample written for each instance, keyed
+ *          by a hash of the serialized instance key. A write whose sample
+ *          hash matches the stored one is suppressed and counted. Disposing
+ *          of an instance forgets it, so the next write always goes out.
+ */
+class ChangeFilter
+{
+public:
+
+    ChangeFilter() : m_enabled(false), m_suppressed(0)
+    {}
+
+    /**
+     * @brief Turn the filter on or off. Turning it off clears all entries.
+     * @param[in] value True to enable the filter.
+     */
+    void enable(bool value)
+    {
+        m_enabled.store(value);
+        if (!value)
+        {
+            clear();
+        }
+    }
+
+    bool isEnabled() const
+    {
+        return m_enabled.load();
+    }
+
+    /// The number of writes suppressed because the sample had not changed.
+    uint64_t suppressedCount() const
+    {
+        return m_suppressed.load();
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastHash.clear();
+    }
+
+    /**
+     * @brief Check a sample against the last one written for its instance.
+     * @details If the sample changed, it is remembered as the last sample.
+     * @param[in] sample The sample about to be written.
+     * @return True if the write should be suppressed; false otherwise.
+     */
+    template <typename TopicType>
+    bool isUnchanged(const TopicType& sample);
+
+    /**
+     * @brief Forget the last sample written for an instance.
+     * @remarks Called after a failed write or a dispose.
+     * @param[in] sample The sample containing the instance key.
+     */
+    template <typename TopicType>
+    void forget(const TopicType& sample);
+
+private:
+
+    std::atomic<bool> m_enabled;
+
+    std::atomic<uint64_t> m_suppressed;
+
+    std::mutex m_mutex;
+
+    /// The key is the hash of the serialized instance key and the value is
+    /// the hash of the last serialized sample.
+    std::unordered_map<uint64_t, uint64_t> m_lastHash;
+};
+
+/**
+ * @brief Tracks the lifetime of a data writer shared with TopicWriter handles.
+ *
+ * @details The topic group owns the data writer. Handles register each write
+ *          with acquire/release so the topic group can wait for in-flight
+ *          writes to finish before it deletes the writer. Neither side takes
+ *          a lock on the write path.
+ */
+class TopicWriterState
+{
+public:
+
+    TopicWriterState() : m_valid(true), m_users(0)
+    {}
+
+    /**
+     * @brief Mark a write as in flight.
+     * @return True if the writer may be used; false if it has been deleted.
+     */
+    bool acquire()
+    {
+        m_users.fetch_add(1);
+        if (!m_valid.load())
+        {
+            release();
+            return false;
+        }
+        return true;
+    }
+
+    /// Mark an in-flight write as finished.
+    void release()
+    {
+        m_users.fetch_sub(1);
+    }
+
+    /**
+     * @brief Reject any new writes and wait for the in-flight writes to finish.
+     * @remarks Called by the topic group right before it deletes the writer.
+     */
+    void invalidate()
+    {
+        m_valid.store(false);
+        while (m_users.load() > 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    bool isValid() const
+    {
+        return m_valid.load();
+    }
+
+    /// Registered instance handles for the writer (disabled by default).
+    InstanceHandleCache instanceCache;
+
+    /// Suppresses writes of unchanged samples (disabled by default).
+    ChangeFilter changeFilter;
+
+private:
+
+    /// False once the owning topic group has started deleting the writer.
+    std::atomic<bool> m_valid;
+
+    /// Number of writes currently using the writer.
+    std::atomic<int> m_users;
+};
+
+
+/**
+ * @brief Pre-resolved handle for writing samples to a topic.
+ *
+ * @details Returned once from DDSManager::getTopicWriter. The typed data
+ *          writer is narrowed when the handle is created, so writing through
+ *          the handle does not lock the manager or look up the topic by name.
+ *          The handle is invalidated when the topic is unregistered; any
+ *          write after that point fails and returns false.
+ */
+template <typename TopicType>
+class TopicWriter
+{
+public:
+
+    typedef typename OpenDDS::DCPS::DDSTraits<TopicType>::DataWriterType::_var_type WriterVar;
+
+    /// Creates an invalid handle.
+    TopicWriter() = default;
+
+    TopicWriter(std::shared_ptr<TopicWriterState> state,
+                WriterVar writer,
+                const std::string& topicName) :
+        m_state(std::move(state)), m_writer(writer), m_topicName(topicName)
+    {}
+
+    /**
+     * @brief Check if the handle can still be written to.
+     * @return True if the topic writer still exists; false otherwise.
+     */
+    bool isValid() const
+    {
+        return m_state && m_writer && m_state->isValid();
+    }
+
+    explicit operator bool() const
+    {
+        return isValid();
+    }
+
+    /// The name of the topic this handle writes to.
+    const std::string& topicName() const
+    {
+        return m_topicName;
+    }
+
+    /**
+     * @brief Write a data sample.
+     * @param[in] sample Write this topic instance as a data sample.
+     * @return True if new data was written; false otherwise.
+     */
+    bool write(const TopicType& sample);
+
+    /**
+     * @brief Dispose of a data sample.
+     * @param[in] sample Dispose of this topic instance as a data sample.
+     * @return True if new data was disposed; false otherwise.
+     */
+    bool dispose(const TopicType& sample);
+
+private:
+
+    std::shared_ptr<TopicWriterState> m_state;
+
+    /// The narrowed data writer for the topic.
+    WriterVar m_writer;
+
+    std::string m_topicName;
+};
+
+#endif
+
+/**
+ * @}
+ */